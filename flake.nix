@@ -29,7 +29,6 @@
             wayland-protocols
             cairo
             pango
-            json_c
             libxkbcommon
             glib
             librsvg
@@ -0,0 +1,72 @@
+#!/bin/bash
+# Snappy Switcher Hyprland IPC Benchmark
+# Replays Hyprland IPC traces from a stand-in socket and times the backend
+# (j/clients fetch, overview/context snapshots, focus dispatch). Runs on a
+# headless box: no compositor or Wayland session needed.
+#
+#   ./scripts/ipc-bench.sh                      synthetic 10..500 windows
+#   ./scripts/ipc-bench.sh session.trace        a recorded session
+#   ./scripts/ipc-bench.sh session.trace --realtime
+#
+# Record a session with: SNAPPY_IPC_TRACE=session.trace snappy-switcher --daemon
+
+REPLAY="./tests/ipc_replay"
+BENCH="./tests/ipc_bench"
+ITERATIONS="${ITERATIONS:-200}"
+SIZES="10 50 100 250 500"
+
+WORK_DIR="$(mktemp -d /tmp/snappy-ipc-bench.XXXXXX)"
+SIG="bench"
+SERVER_PID=""
+
+cleanup() {
+    [ -n "$SERVER_PID" ] && kill "$SERVER_PID" 2>/dev/null
+    wait 2>/dev/null
+    rm -rf "$WORK_DIR"
+}
+trap cleanup EXIT
+
+for bin in "$REPLAY" "$BENCH"; do
+    if [ ! -x "$bin" ]; then
+        echo "$bin not built (run: make bench-ipc)"
+        exit 1
+    fi
+done
+
+# run_trace <trace> [--realtime]
+run_trace() {
+    local dir="$WORK_DIR/hypr/$SIG"
+    rm -rf "$dir"
+    mkdir -p "$dir"
+
+    "$REPLAY" serve "$1" "$dir" $2 >/dev/null 2>&1 &
+    SERVER_PID=$!
+    for _ in $(seq 50); do
+        [ -S "$dir/.socket2.sock" ] && break
+        sleep 0.05
+    done
+
+    # Drop the backend's own log lines, keep the timings and any errors
+    "$BENCH" "$WORK_DIR" "$SIG" "$ITERATIONS" 2>&1 | grep -v '^\[Hyprland\]'
+    local rc=${PIPESTATUS[0]}
+
+    kill "$SERVER_PID" 2>/dev/null
+    wait "$SERVER_PID" 2>/dev/null
+    SERVER_PID=""
+    return "$rc"
+}
+
+FAILED=0
+if [ $# -gt 0 ]; then
+    echo "=== $1 ==="
+    run_trace "$1" "$2" || FAILED=1
+else
+    for n in $SIZES; do
+        "$REPLAY" generate "$n" > "$WORK_DIR/$n.trace"
+        echo "=== $n windows ==="
+        run_trace "$WORK_DIR/$n.trace" || FAILED=1
+        echo ""
+    done
+fi
+
+exit $FAILED
@@ -0,0 +1,166 @@
+#!/bin/bash
+# Snappy Switcher Stalled-Compositor Test
+# Runs the daemon against a fake Hyprland IPC socket that accepts requests
+# but never answers, and checks the daemon stays responsive.
+# Needs a running Wayland session (for the panel) and python3.
+
+BINARY="./snappy-switcher"
+PASS=0
+FAIL=0
+
+SIG="snappy-stall-test-$$"
+FAKE_DIR="$XDG_RUNTIME_DIR/hypr/$SIG"
+DAEMON_LOG="$(mktemp /tmp/snappy-stall-test.XXXXXX)"
+FAKE_PID=""
+PID=""
+
+log() { echo "[$(date +%H:%M:%S)] $1"; }
+pass() { ((PASS++)); log "✅ PASS: $1"; }
+fail() { ((FAIL++)); log "❌ FAIL: $1"; }
+
+cleanup() {
+    [ -n "$PID" ] && kill "$PID" 2>/dev/null
+    [ -n "$FAKE_PID" ] && kill "$FAKE_PID" 2>/dev/null
+    wait 2>/dev/null
+    rm -rf "$FAKE_DIR"
+    rm -f "$DAEMON_LOG"
+}
+trap cleanup EXIT
+
+# Fake Hyprland: .socket.sock answers j/clients with two windows unless
+# $FAKE_DIR/stall exists, in which case it reads the request and hangs.
+# .socket2.sock accepts subscribers and never sends an event.
+start_fake_hyprland() {
+    mkdir -p "$FAKE_DIR"
+    python3 - "$FAKE_DIR" <<'PY' &
+import os, socket, sys, threading, time
+
+d = sys.argv[1]
+clients = (b'[{"address":"0x1","workspace":{"id":1,"name":"1"},'
+           b'"floating":false,"class":"kitty","title":"one","focusHistoryID":0},'
+           b'{"address":"0x2","workspace":{"id":1,"name":"1"},'
+           b'"floating":false,"class":"firefox","title":"two","focusHistoryID":1}]')
+
+def serve(name, handler):
+    s = socket.socket(socket.AF_UNIX)
+    s.bind(os.path.join(d, name))
+    s.listen(64)
+    while True:
+        conn, _ = s.accept()
+        threading.Thread(target=handler, args=(conn,), daemon=True).start()
+
+def request(conn):
+    data = conn.recv(4096)
+    if os.path.exists(os.path.join(d, "stall")):
+        time.sleep(3600)
+    conn.sendall(clients if data.startswith(b"j/clients") else b"ok")
+    conn.close()
+
+def events(conn):
+    time.sleep(3600)
+
+threading.Thread(target=serve, args=(".socket2.sock", events), daemon=True).start()
+serve(".socket.sock", request)
+PY
+    FAKE_PID=$!
+    for _ in $(seq 1 20); do
+        [ -S "$FAKE_DIR/.socket.sock" ] && return 0
+        sleep 0.1
+    done
+    return 1
+}
+
+# Milliseconds taken by one client command
+time_command() {
+    local start end
+    start=$(date +%s%N)
+    $BINARY "$1" >/dev/null 2>&1
+    end=$(date +%s%N)
+    echo $(( (end - start) / 1000000 ))
+}
+
+# Test 1: Startup is bounded even though the initial fetch never returns
+test_stalled_startup() {
+    log "Test 1: Startup Against Stalled Compositor"
+    touch "$FAKE_DIR/stall"
+    HYPRLAND_INSTANCE_SIGNATURE="$SIG" $BINARY --daemon >"$DAEMON_LOG" 2>&1 &
+    PID=$!
+    sleep 2
+
+    if ps -p "$PID" >/dev/null 2>&1 && grep -q "Window fetch timed out" "$DAEMON_LOG"; then
+        pass "Daemon started, initial fetch timed out"
+    else
+        fail "Daemon did not start past the stalled fetch"
+    fi
+}
+
+# Test 2: Commands are served while a fetch is stuck in flight
+test_responsive() {
+    log "Test 2: Responsiveness While Fetch Is Stalled"
+    local worst=0 ms
+    for _ in $(seq 1 10); do
+        ms=$(time_command toggle)
+        [ "$ms" -gt "$worst" ] && worst=$ms
+        ms=$(time_command stats)
+        [ "$ms" -gt "$worst" ] && worst=$ms
+        sleep 0.1
+    done
+    $BINARY hide >/dev/null 2>&1
+
+    log "  Slowest command: ${worst}ms"
+    if [ "$worst" -lt 250 ]; then
+        pass "Commands answered promptly with compositor stalled"
+    else
+        fail "Commands waited on the stalled compositor"
+    fi
+}
+
+# Test 3: Once the compositor recovers the list is refreshed
+test_recovery() {
+    log "Test 3: Recovery After Stall"
+    rm -f "$FAKE_DIR/stall"
+    sleep 0.6 # let any in-flight fetch hit its deadline
+    $BINARY toggle >/dev/null 2>&1
+    sleep 0.5
+    $BINARY hide >/dev/null 2>&1
+
+    if grep -q "Resynced window model: 2 windows" "$DAEMON_LOG"; then
+        pass "Window list refreshed after compositor recovered"
+    else
+        fail "Window list never refreshed"
+    fi
+}
+
+# Main
+main() {
+    log "========================================="
+    log "Snappy Switcher Stalled-Compositor Test"
+    log "========================================="
+
+    if [ -z "$XDG_RUNTIME_DIR" ] || ! command -v python3 >/dev/null; then
+        log "Needs XDG_RUNTIME_DIR and python3, skipping"
+        exit 0
+    fi
+
+    if [ ! -f "$BINARY" ]; then
+        log "Building..."
+        make clean && make
+    fi
+
+    if ! start_fake_hyprland; then
+        log "Fake Hyprland socket did not come up"
+        exit 1
+    fi
+
+    test_stalled_startup
+    test_responsive
+    test_recovery
+
+    log "========================================="
+    log "Results: $PASS passed, $FAIL failed"
+    log "========================================="
+
+    [ $FAIL -eq 0 ]
+}
+
+main
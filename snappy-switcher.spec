@@ -20,7 +20,6 @@ BuildRequires:  cairo-devel
 BuildRequires:  pango-devel
 BuildRequires:  libxkbcommon-devel
 BuildRequires:  glib2-devel
-BuildRequires:  json-c-devel
 BuildRequires:  librsvg2-devel
 
 # Runtime dependencies
@@ -29,7 +28,6 @@ Requires:       cairo
 Requires:       pango
 Requires:       libxkbcommon
 Requires:       glib2
-Requires:       json-c
 Requires:       librsvg2
 
 # Recommended (not hard requirements)
@@ -0,0 +1,102 @@
+/* src/arena.c - Bump allocator and counted heap for window data */
+#include "arena.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define ARENA_BLOCK_SIZE 16384
+#define ARENA_ALIGN 16
+
+struct ArenaBlock {
+  ArenaBlock *next;
+  size_t size;
+  size_t used;
+  _Alignas(ARENA_ALIGN) char data[];
+};
+
+static size_t allocations = 0;
+
+static ArenaBlock *block_new(size_t size) {
+  ArenaBlock *block = heap_alloc(sizeof(ArenaBlock) + size);
+  if (!block)
+    return NULL;
+  block->next = NULL;
+  block->size = size;
+  block->used = 0;
+  return block;
+}
+
+void *arena_alloc(Arena *arena, size_t size) {
+  size = (size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+
+  ArenaBlock *head = arena->head;
+  if (!head || head->size - head->used < size) {
+    size_t block_size = head ? head->size * 2 : ARENA_BLOCK_SIZE;
+    if (block_size < size)
+      block_size = size;
+
+    ArenaBlock *block = block_new(block_size);
+    if (!block)
+      return NULL;
+    block->next = head;
+    arena->head = head = block;
+  }
+
+  void *ptr = head->data + head->used;
+  head->used += size;
+  return ptr;
+}
+
+char *arena_strdup(Arena *arena, const char *str) {
+  if (!str)
+    str = "";
+  size_t len = strlen(str) + 1;
+  char *copy = arena_alloc(arena, len);
+  if (copy)
+    memcpy(copy, str, len);
+  return copy;
+}
+
+void arena_reset(Arena *arena) {
+  ArenaBlock *head = arena->head;
+  if (!head)
+    return;
+
+  if (head->next) {
+    /* Coalesce into a single block big enough for the whole workload */
+    size_t total = 0;
+    for (ArenaBlock *b = head; b; b = b->next)
+      total += b->size;
+    arena_free(arena);
+    arena->head = block_new(total);
+    return;
+  }
+
+  head->used = 0;
+}
+
+void arena_free(Arena *arena) {
+  ArenaBlock *block = arena->head;
+  while (block) {
+    ArenaBlock *next = block->next;
+    free(block);
+    block = next;
+  }
+  arena->head = NULL;
+}
+
+void *heap_alloc(size_t size) {
+  allocations++;
+  return malloc(size);
+}
+
+void *heap_realloc(void *ptr, size_t size) {
+  allocations++;
+  return realloc(ptr, size);
+}
+
+char *heap_strdup(const char *str) {
+  allocations++;
+  return strdup(str ? str : "");
+}
+
+size_t heap_allocations(void) { return allocations; }
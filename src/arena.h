@@ -0,0 +1,42 @@
+/* src/arena.h - Bump allocator and counted heap for window data */
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+typedef struct ArenaBlock ArenaBlock;
+
+/* Bump arena: allocations are freed all at once by arena_reset() */
+typedef struct {
+  ArenaBlock *head; /* Current block (older blocks chained behind it) */
+} Arena;
+
+/* Allocate size bytes (suitably aligned), NULL on failure */
+void *arena_alloc(Arena *arena, size_t size);
+
+/* Copy a string into the arena (NULL becomes "") */
+char *arena_strdup(Arena *arena, const char *str);
+
+/*
+ * Drop all allocations. Memory is kept for reuse; if the arena had to grow
+ * into several blocks they are merged into one, so a steady-state workload
+ * stops touching the heap after the first few cycles.
+ */
+void arena_reset(Arena *arena);
+
+/* Release all memory held by the arena */
+void arena_free(Arena *arena);
+
+/*
+ * Heap allocations for window data: arena blocks, and the window model and
+ * malloc-backed snapshot strings and arrays outside arenas. They are
+ * counted so that a steady-state show can be checked to make none.
+ */
+void *heap_alloc(size_t size);
+void *heap_realloc(void *ptr, size_t size);
+char *heap_strdup(const char *str); /* NULL becomes "" */
+
+/* Number of heap_alloc/heap_realloc/heap_strdup calls so far */
+size_t heap_allocations(void);
+
+#endif /* ARENA_H */
@@ -0,0 +1,128 @@
+/* src/atoms.c - Interned class names */
+#include "atoms.h"
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ATOM_MIN_SLOTS 64
+
+typedef struct {
+  char *name;
+  char *lower;
+  uint32_t hash;
+} AtomEntry;
+
+/* entries[atom - 1]; slots[] is an open-addressing index into it */
+static AtomEntry *entries = NULL;
+static uint32_t entry_count = 0;
+static uint32_t entry_capacity = 0;
+static Atom *slots = NULL;
+static uint32_t slot_count = 0;
+
+static uint32_t hash_name(const char *str) {
+  uint32_t hash = 5381;
+  int c;
+  while ((c = (unsigned char)*str++))
+    hash = ((hash << 5) + hash) + c;
+  return hash;
+}
+
+static int grow_slots(void) {
+  uint32_t new_count = slot_count ? slot_count * 2 : ATOM_MIN_SLOTS;
+  Atom *new_slots = calloc(new_count, sizeof(Atom));
+  if (!new_slots)
+    return -1;
+
+  for (uint32_t i = 0; i < entry_count; i++) {
+    uint32_t s = entries[i].hash & (new_count - 1);
+    while (new_slots[s] != ATOM_NONE)
+      s = (s + 1) & (new_count - 1);
+    new_slots[s] = i + 1;
+  }
+
+  free(slots);
+  slots = new_slots;
+  slot_count = new_count;
+  return 0;
+}
+
+Atom atom_intern(const char *name) {
+  if (!name || !name[0])
+    return ATOM_NONE;
+
+  uint32_t hash = hash_name(name);
+
+  if (slot_count) {
+    uint32_t s = hash & (slot_count - 1);
+    while (slots[s] != ATOM_NONE) {
+      AtomEntry *e = &entries[slots[s] - 1];
+      if (e->hash == hash && strcmp(e->name, name) == 0)
+        return slots[s];
+      s = (s + 1) & (slot_count - 1);
+    }
+  }
+
+  /* Keep the index at most half full */
+  if ((entry_count + 1) * 2 > slot_count && grow_slots() < 0)
+    return ATOM_NONE;
+
+  if (entry_count == entry_capacity) {
+    uint32_t new_capacity = entry_capacity ? entry_capacity * 2 : 32;
+    AtomEntry *new_entries =
+        realloc(entries, new_capacity * sizeof(AtomEntry));
+    if (!new_entries)
+      return ATOM_NONE;
+    entries = new_entries;
+    entry_capacity = new_capacity;
+  }
+
+  size_t len = strlen(name);
+  char *copy = malloc(2 * (len + 1));
+  if (!copy)
+    return ATOM_NONE;
+  memcpy(copy, name, len + 1);
+  char *lower = copy + len + 1;
+  for (size_t i = 0; i <= len; i++)
+    lower[i] = tolower((unsigned char)name[i]);
+
+  AtomEntry *e = &entries[entry_count];
+  e->name = copy;
+  e->lower = lower;
+  e->hash = hash;
+  Atom atom = ++entry_count;
+
+  uint32_t s = hash & (slot_count - 1);
+  while (slots[s] != ATOM_NONE)
+    s = (s + 1) & (slot_count - 1);
+  slots[s] = atom;
+
+  return atom;
+}
+
+const char *atom_name(Atom atom) {
+  if (atom == ATOM_NONE || atom > entry_count)
+    return "";
+  return entries[atom - 1].name;
+}
+
+const char *atom_lower(Atom atom) {
+  if (atom == ATOM_NONE || atom > entry_count)
+    return "";
+  return entries[atom - 1].lower;
+}
+
+uint32_t atom_hash(Atom atom) {
+  if (atom == ATOM_NONE || atom > entry_count)
+    return 5381;
+  return entries[atom - 1].hash;
+}
+
+void atoms_cleanup(void) {
+  for (uint32_t i = 0; i < entry_count; i++)
+    free(entries[i].name);
+  free(entries);
+  free(slots);
+  entries = NULL;
+  slots = NULL;
+  entry_count = entry_capacity = slot_count = 0;
+}
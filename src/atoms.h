@@ -0,0 +1,31 @@
+/* src/atoms.h - Interned class names */
+#ifndef ATOMS_H
+#define ATOMS_H
+
+#include <stdint.h>
+
+/*
+ * A class name interned once for the life of the process. Equal names get
+ * equal atoms, so comparing, hashing and cache lookups are integer
+ * operations. ATOM_NONE stands for a missing or empty name.
+ */
+typedef uint32_t Atom;
+
+#define ATOM_NONE 0
+
+/* Intern a class name (NULL or "" gives ATOM_NONE, as does OOM) */
+Atom atom_intern(const char *name);
+
+/* Original spelling ("" for ATOM_NONE); valid until atoms_cleanup() */
+const char *atom_name(Atom atom);
+
+/* Lowercased spelling */
+const char *atom_lower(Atom atom);
+
+/* Precomputed djb2 hash of the original spelling */
+uint32_t atom_hash(Atom atom);
+
+/* Free the table */
+void atoms_cleanup(void);
+
+#endif /* ATOMS_H */
@@ -15,13 +15,21 @@ static Backend backends[] = {{.type = BACKEND_HYPRLAND,
                               .cleanup = hyprland_backend_cleanup,
                               .get_windows = update_window_list,
                               .activate_window = switch_to_window,
-                              .get_name = hyprland_get_name},
+                              .get_name = hyprland_get_name,
+                              .get_poll_fds = hyprland_get_poll_fds,
+                              .get_timeout = hyprland_get_timeout,
+                              .dispatch_events = hyprland_dispatch_events,
+                              .get_generation = hyprland_get_generation,
+                              .request_previews = hyprland_request_previews},
                              {.type = BACKEND_WLR,
                               .init = wlr_backend_init,
                               .cleanup = wlr_backend_cleanup,
                               .get_windows = wlr_get_windows,
                               .activate_window = wlr_activate_window,
-                              .get_name = wlr_get_name}};
+                              .get_name = wlr_get_name,
+                              .get_generation = wlr_get_generation,
+                              .bind_global = wlr_backend_bind_global,
+                              .remove_global = wlr_backend_remove_global}};
 
 static Backend *current_backend = NULL;
 
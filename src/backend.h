@@ -4,6 +4,13 @@
 
 #include "config.h"
 #include "data.h"
+#include <poll.h>
+#include <stdint.h>
+
+struct wl_registry;
+
+/* Most fds a backend may ask the daemon to poll */
+#define BACKEND_MAX_POLL_FDS 16
 
 /* Backend types */
 typedef enum { BACKEND_HYPRLAND, BACKEND_WLR, BACKEND_UNKNOWN } BackendType;
@@ -16,6 +23,24 @@ typedef struct {
   int (*get_windows)(AppState *state, Config *config);
   void (*activate_window)(const char *identifier);
   const char *(*get_name)(void);
+  /* Optional: fill fds the daemon polls for backend events, returns count */
+  int (*get_poll_fds)(struct pollfd *fds, int max);
+  /* Optional: ms until the backend needs dispatching regardless (-1 none) */
+  int (*get_timeout)(void);
+  /* Optional: called when any of those fds is ready or the timeout expires;
+   * returns true when the window list was refreshed behind a snapshot */
+  bool (*dispatch_events)(void);
+  /* Optional: changes whenever the window list get_windows() would return
+   * changes; 0 means "unknown", and the snapshot is always rebuilt */
+  uint64_t (*get_generation)(void);
+  /* Optional: bind globals the backend needs on the daemon's display;
+   * called for every global the daemon does not bind itself */
+  void (*bind_global)(struct wl_registry *registry, uint32_t name,
+                      const char *interface, uint32_t version);
+  /* Optional: a global announced through bind_global was removed */
+  void (*remove_global)(uint32_t name);
+  /* Optional: queue preview captures once the capture protocol is bound */
+  void (*request_previews)(void);
 } Backend;
 
 /* Initialize backend system, auto-detects which backend to use */
@@ -0,0 +1,525 @@
+/* src/blit.c - Pixel kernels for the flat parts of a frame */
+#include "blit.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#define HAVE_X86_SIMD 1
+#endif
+
+#define LOG(fmt, ...) fprintf(stderr, "[Blit] " fmt "\n", ##__VA_ARGS__)
+
+/* Span kernels: n pixels of src, of one colour, or of one colour masked */
+typedef struct {
+  const char *name;
+  void (*over)(uint32_t *dst, const uint32_t *src, int n);
+  void (*over_solid)(uint32_t *dst, uint32_t color, int n);
+  void (*over_mask)(uint32_t *dst, uint32_t color, const uint8_t *mask, int n);
+} Kernels;
+
+/* x / 255, rounded, exact for x <= 255 * 255; the SIMD spans match it */
+static inline uint32_t div255(uint32_t x) {
+  x += 128;
+  return (x + (x >> 8)) >> 8;
+}
+
+static inline uint32_t over_pixel(uint32_t s, uint32_t d) {
+  uint32_t ia = 255 - (s >> 24);
+  uint32_t out = 0;
+  for (int shift = 0; shift < 32; shift += 8) {
+    uint32_t c = ((s >> shift) & 0xff) + div255(((d >> shift) & 0xff) * ia);
+    out |= (c > 255 ? 255 : c) << shift;
+  }
+  return out;
+}
+
+static void scalar_over(uint32_t *dst, const uint32_t *src, int n) {
+  for (int i = 0; i < n; i++) {
+    uint32_t s = src[i];
+    if (s >= 0xff000000)
+      dst[i] = s;
+    else if (s)
+      dst[i] = over_pixel(s, dst[i]);
+  }
+}
+
+static void scalar_over_solid(uint32_t *dst, uint32_t color, int n) {
+  if (color >= 0xff000000) {
+    for (int i = 0; i < n; i++)
+      dst[i] = color;
+    return;
+  }
+  for (int i = 0; i < n; i++)
+    dst[i] = over_pixel(color, dst[i]);
+}
+
+/* The premultiplied colour scaled by alpha 0..255 */
+static inline uint32_t scale_alpha(uint32_t color, uint32_t a) {
+  if (a >= 255)
+    return color;
+  uint32_t out = 0;
+  for (int shift = 0; shift < 32; shift += 8)
+    out |= div255(((color >> shift) & 0xff) * a) << shift;
+  return out;
+}
+
+static void scalar_over_mask(uint32_t *dst, uint32_t color,
+                             const uint8_t *mask, int n) {
+  for (int i = 0; i < n; i++) {
+    if (mask[i])
+      dst[i] = over_pixel(scale_alpha(color, mask[i]), dst[i]);
+  }
+}
+
+static const Kernels scalar_kernels = {"scalar", scalar_over,
+                                       scalar_over_solid, scalar_over_mask};
+
+#ifdef HAVE_X86_SIMD
+/* Four pixels of s over d, 16 bits per channel, same rounding as div255 */
+static inline __m128i over4_sse2(__m128i s, __m128i d) {
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i bias = _mm_set1_epi16(128);
+
+  /* 255 - alpha, in all four 16-bit channels of each pixel */
+  __m128i ia = _mm_sub_epi32(_mm_set1_epi32(255), _mm_srli_epi32(s, 24));
+  ia = _mm_or_si128(ia, _mm_slli_epi32(ia, 16));
+  __m128i ia_lo = _mm_unpacklo_epi32(ia, ia);
+  __m128i ia_hi = _mm_unpackhi_epi32(ia, ia);
+
+  __m128i lo = _mm_add_epi16(
+      _mm_mullo_epi16(_mm_unpacklo_epi8(d, zero), ia_lo), bias);
+  __m128i hi = _mm_add_epi16(
+      _mm_mullo_epi16(_mm_unpackhi_epi8(d, zero), ia_hi), bias);
+  lo = _mm_srli_epi16(_mm_add_epi16(lo, _mm_srli_epi16(lo, 8)), 8);
+  hi = _mm_srli_epi16(_mm_add_epi16(hi, _mm_srli_epi16(hi, 8)), 8);
+  return _mm_adds_epu8(s, _mm_packus_epi16(lo, hi));
+}
+
+static void sse2_over(uint32_t *dst, const uint32_t *src, int n) {
+  const __m128i amask = _mm_set1_epi32((int)0xff000000);
+  const __m128i zero = _mm_setzero_si128();
+  int i = 0;
+  for (; i + 4 <= n; i += 4) {
+    __m128i s = _mm_loadu_si128((const __m128i *)(src + i));
+    if (_mm_movemask_epi8(_mm_cmpeq_epi32(_mm_and_si128(s, amask), amask)) ==
+        0xffff) {
+      _mm_storeu_si128((__m128i *)(dst + i), s);
+      continue;
+    }
+    if (_mm_movemask_epi8(_mm_cmpeq_epi32(s, zero)) == 0xffff)
+      continue;
+    __m128i d = _mm_loadu_si128((const __m128i *)(dst + i));
+    _mm_storeu_si128((__m128i *)(dst + i), over4_sse2(s, d));
+  }
+  scalar_over(dst + i, src + i, n - i);
+}
+
+static void sse2_over_solid(uint32_t *dst, uint32_t color, int n) {
+  __m128i s = _mm_set1_epi32((int)color);
+  bool opaque = color >= 0xff000000;
+  int i = 0;
+  for (; i + 4 <= n; i += 4) {
+    __m128i *p = (__m128i *)(dst + i);
+    _mm_storeu_si128(p, opaque ? s : over4_sse2(s, _mm_loadu_si128(p)));
+  }
+  scalar_over_solid(dst + i, color, n - i);
+}
+
+/* Four pixels of color (16 bits per channel, two pixels) scaled by mask */
+static inline __m128i scale4_sse2(__m128i color16, const uint8_t *mask) {
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i bias = _mm_set1_epi16(128);
+
+  /* Each mask byte in all four channels of its pixel */
+  uint32_t m;
+  memcpy(&m, mask, 4);
+  __m128i a = _mm_cvtsi32_si128((int)m);
+  a = _mm_unpacklo_epi8(a, a);
+  a = _mm_unpacklo_epi16(a, a);
+
+  __m128i lo = _mm_add_epi16(
+      _mm_mullo_epi16(color16, _mm_unpacklo_epi8(a, zero)), bias);
+  __m128i hi = _mm_add_epi16(
+      _mm_mullo_epi16(color16, _mm_unpackhi_epi8(a, zero)), bias);
+  lo = _mm_srli_epi16(_mm_add_epi16(lo, _mm_srli_epi16(lo, 8)), 8);
+  hi = _mm_srli_epi16(_mm_add_epi16(hi, _mm_srli_epi16(hi, 8)), 8);
+  return _mm_packus_epi16(lo, hi);
+}
+
+static void sse2_over_mask(uint32_t *dst, uint32_t color, const uint8_t *mask,
+                           int n) {
+  __m128i color16 =
+      _mm_unpacklo_epi8(_mm_set1_epi32((int)color), _mm_setzero_si128());
+  int i = 0;
+  for (; i + 4 <= n; i += 4) {
+    uint32_t m;
+    memcpy(&m, mask + i, 4);
+    if (!m)
+      continue;
+    __m128i *p = (__m128i *)(dst + i);
+    _mm_storeu_si128(
+        p, over4_sse2(scale4_sse2(color16, mask + i), _mm_loadu_si128(p)));
+  }
+  scalar_over_mask(dst + i, color, mask + i, n - i);
+}
+
+static const Kernels sse2_kernels = {"sse2", sse2_over, sse2_over_solid,
+                                     sse2_over_mask};
+
+/* over4_sse2() on eight pixels; unpack and pack both stay within lanes */
+__attribute__((target("avx2"))) static inline __m256i over8_avx2(__m256i s,
+                                                                 __m256i d) {
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i bias = _mm256_set1_epi16(128);
+
+  __m256i ia =
+      _mm256_sub_epi32(_mm256_set1_epi32(255), _mm256_srli_epi32(s, 24));
+  ia = _mm256_or_si256(ia, _mm256_slli_epi32(ia, 16));
+  __m256i ia_lo = _mm256_unpacklo_epi32(ia, ia);
+  __m256i ia_hi = _mm256_unpackhi_epi32(ia, ia);
+
+  __m256i lo = _mm256_add_epi16(
+      _mm256_mullo_epi16(_mm256_unpacklo_epi8(d, zero), ia_lo), bias);
+  __m256i hi = _mm256_add_epi16(
+      _mm256_mullo_epi16(_mm256_unpackhi_epi8(d, zero), ia_hi), bias);
+  lo = _mm256_srli_epi16(_mm256_add_epi16(lo, _mm256_srli_epi16(lo, 8)), 8);
+  hi = _mm256_srli_epi16(_mm256_add_epi16(hi, _mm256_srli_epi16(hi, 8)), 8);
+  return _mm256_adds_epu8(s, _mm256_packus_epi16(lo, hi));
+}
+
+__attribute__((target("avx2"))) static void
+avx2_over(uint32_t *dst, const uint32_t *src, int n) {
+  const __m256i amask = _mm256_set1_epi32((int)0xff000000);
+  const __m256i zero = _mm256_setzero_si256();
+  int i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m256i s = _mm256_loadu_si256((const __m256i *)(src + i));
+    if (_mm256_movemask_epi8(_mm256_cmpeq_epi32(
+            _mm256_and_si256(s, amask), amask)) == -1) {
+      _mm256_storeu_si256((__m256i *)(dst + i), s);
+      continue;
+    }
+    if (_mm256_movemask_epi8(_mm256_cmpeq_epi32(s, zero)) == -1)
+      continue;
+    __m256i d = _mm256_loadu_si256((const __m256i *)(dst + i));
+    _mm256_storeu_si256((__m256i *)(dst + i), over8_avx2(s, d));
+  }
+  sse2_over(dst + i, src + i, n - i);
+}
+
+__attribute__((target("avx2"))) static void
+avx2_over_solid(uint32_t *dst, uint32_t color, int n) {
+  __m256i s = _mm256_set1_epi32((int)color);
+  bool opaque = color >= 0xff000000;
+  int i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m256i *p = (__m256i *)(dst + i);
+    _mm256_storeu_si256(p,
+                        opaque ? s : over8_avx2(s, _mm256_loadu_si256(p)));
+  }
+  sse2_over_solid(dst + i, color, n - i);
+}
+
+/* scale4_sse2() on eight pixels */
+__attribute__((target("avx2"))) static inline __m256i
+scale8_avx2(__m256i color16, const uint8_t *mask) {
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i bias = _mm256_set1_epi16(128);
+
+  /* Widen each mask byte to its pixel, then copy it to every channel */
+  __m256i a = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)mask));
+  a = _mm256_mullo_epi32(a, _mm256_set1_epi32(0x01010101));
+
+  __m256i lo = _mm256_add_epi16(
+      _mm256_mullo_epi16(color16, _mm256_unpacklo_epi8(a, zero)), bias);
+  __m256i hi = _mm256_add_epi16(
+      _mm256_mullo_epi16(color16, _mm256_unpackhi_epi8(a, zero)), bias);
+  lo = _mm256_srli_epi16(_mm256_add_epi16(lo, _mm256_srli_epi16(lo, 8)), 8);
+  hi = _mm256_srli_epi16(_mm256_add_epi16(hi, _mm256_srli_epi16(hi, 8)), 8);
+  return _mm256_packus_epi16(lo, hi);
+}
+
+__attribute__((target("avx2"))) static void
+avx2_over_mask(uint32_t *dst, uint32_t color, const uint8_t *mask, int n) {
+  __m256i color16 = _mm256_unpacklo_epi8(_mm256_set1_epi32((int)color),
+                                         _mm256_setzero_si256());
+  int i = 0;
+  for (; i + 8 <= n; i += 8) {
+    uint64_t m;
+    memcpy(&m, mask + i, 8);
+    if (!m)
+      continue;
+    __m256i *p = (__m256i *)(dst + i);
+    _mm256_storeu_si256(p, over8_avx2(scale8_avx2(color16, mask + i),
+                                      _mm256_loadu_si256(p)));
+  }
+  sse2_over_mask(dst + i, color, mask + i, n - i);
+}
+
+static const Kernels avx2_kernels = {"avx2", avx2_over, avx2_over_solid,
+                                     avx2_over_mask};
+#endif
+
+static const Kernels *kernels = &scalar_kernels;
+
+bool blit_use(const char *isa) {
+  if (strcmp(isa, "scalar") == 0) {
+    kernels = &scalar_kernels;
+    return true;
+  }
+#ifdef HAVE_X86_SIMD
+  /* SSE2 is part of x86-64 */
+  if (strcmp(isa, "sse2") == 0) {
+    kernels = &sse2_kernels;
+    return true;
+  }
+  if (strcmp(isa, "avx2") == 0 && __builtin_cpu_supports("avx2")) {
+    kernels = &avx2_kernels;
+    return true;
+  }
+#endif
+  return false;
+}
+
+void blit_init(void) {
+  const char *isa = getenv("SNAPPY_SIMD");
+  if (isa && *isa) {
+    if (blit_use(isa))
+      return;
+    LOG("SNAPPY_SIMD=%s not supported here", isa);
+  }
+  if (!blit_use("avx2") && !blit_use("sse2"))
+    blit_use("scalar");
+}
+
+const char *blit_isa(void) { return kernels->name; }
+
+static inline uint32_t *pixel_row(const BlitImage *img, int y) {
+  return (uint32_t *)(img->data + (size_t)y * img->stride);
+}
+
+void blit_copy(BlitImage *dst, const BlitImage *src) {
+  int x0 = dst->x0, x1 = dst->x1 < src->width ? dst->x1 : src->width;
+  int y1 = dst->y1 < src->height ? dst->y1 : src->height;
+  if (x0 >= x1)
+    return;
+  /* Plain rows: libc's memcpy is already as wide as the CPU allows */
+  for (int y = dst->y0; y < y1; y++)
+    memcpy(pixel_row(dst, y) + x0, pixel_row(src, y) + x0,
+           (size_t)(x1 - x0) * 4);
+}
+
+void blit_over(BlitImage *dst, const BlitImage *src, int x, int y) {
+  int x0 = x > dst->x0 ? x : dst->x0;
+  int y0 = y > dst->y0 ? y : dst->y0;
+  int x1 = x + src->width < dst->x1 ? x + src->width : dst->x1;
+  int y1 = y + src->height < dst->y1 ? y + src->height : dst->y1;
+  if (x0 >= x1)
+    return;
+  for (int row = y0; row < y1; row++)
+    kernels->over(pixel_row(dst, row) + x0, pixel_row(src, row - y) + x0 - x,
+                  x1 - x0);
+}
+
+/* Length of [p, p + 1) inside [a, b) */
+static inline double overlap(int p, double a, double b) {
+  double lo = p > a ? p : a;
+  double hi = p + 1 < b ? p + 1 : b;
+  return hi > lo ? hi - lo : 0;
+}
+
+/* Coverage 0..1 as alpha, rounded as the fills have always done it */
+static inline uint32_t coverage_alpha(double coverage) {
+  if (coverage <= 0)
+    return 0;
+  if (coverage >= 1)
+    return 255;
+  return (uint32_t)(coverage * 255 + 0.5);
+}
+
+/*
+ * Alpha of a corner arc, for the pixel i columns and j rows further out
+ * than the pixel nearest the arc centre that is still outside it, whose
+ * centre lies (dx0, dy0) from the arc centre. Only the radius and those
+ * offsets matter, so every card sharing a radius and pixel phase uses the
+ * same table; each thread builds one once and keeps the last few.
+ */
+#define CORNER_MAX 64
+#define CORNER_TABLES 8
+
+typedef struct {
+  double r, dx0, dy0;
+  uint64_t stamp; /* Last use, 0 = empty */
+  uint8_t alpha[CORNER_MAX * CORNER_MAX];
+} CornerTable;
+
+static _Thread_local CornerTable corner_tables[CORNER_TABLES];
+static _Thread_local uint64_t corner_tick = 0;
+
+static inline uint32_t arc_alpha(double r, double dx, double dy) {
+  return coverage_alpha(r + 0.5 - sqrt(dx * dx + dy * dy));
+}
+
+/* NULL if r is too large for a table: such arcs are computed per pixel */
+static const CornerTable *corner_table(double r, double dx0, double dy0) {
+  if (r > CORNER_MAX - 2)
+    return NULL;
+
+  /* Least recently used, so a fill never evicts its own other corners */
+  CornerTable *table = &corner_tables[0];
+  for (int i = 0; i < CORNER_TABLES; i++) {
+    CornerTable *t = &corner_tables[i];
+    if (t->stamp && t->r == r && t->dx0 == dx0 && t->dy0 == dy0) {
+      t->stamp = ++corner_tick;
+      return t;
+    }
+    if (t->stamp < table->stamp)
+      table = t;
+  }
+
+  for (int j = 0; j < CORNER_MAX; j++)
+    for (int i = 0; i < CORNER_MAX; i++)
+      table->alpha[j * CORNER_MAX + i] = arc_alpha(r, dx0 + i, dy0 + j);
+  table->r = r;
+  table->dx0 = dx0;
+  table->dy0 = dy0;
+  table->stamp = ++corner_tick;
+  return table;
+}
+
+/* One corner of a fill: the column and row nearest its centre, outside it */
+typedef struct {
+  const CornerTable *table;
+  double dx0, dy0;
+} Corner;
+
+static inline uint32_t corner_alpha(const Corner *c, double r, int i, int j) {
+  if (!c->table)
+    return arc_alpha(r, c->dx0 + i, c->dy0 + j);
+  if (i >= CORNER_MAX || j >= CORNER_MAX)
+    return 0;
+  return c->table->alpha[j * CORNER_MAX + i];
+}
+
+/* Geometry of one fill, as its edge columns need it */
+typedef struct {
+  double x, w, r;
+  uint32_t color;
+  int lx, rx; /* Last column left of the left arcs, first right of the right */
+} Fill;
+
+/*
+ * Pixels [px0, px1) of a row near the left or right edge: the horizontal
+ * coverage times cov_y, cut by the arcs in corner rows (j >= 0, with the
+ * row's left and right corners), as a mask for the span kernel.
+ */
+static void fill_edge(uint32_t *row, int px0, int px1, const Fill *f,
+                      double cov_y, int j, const Corner *left,
+                      const Corner *right) {
+  uint8_t mask[64];
+  while (px0 < px1) {
+    int n = px1 - px0 < (int)sizeof(mask) ? px1 - px0 : (int)sizeof(mask);
+    for (int k = 0; k < n; k++) {
+      int px = px0 + k;
+      uint32_t a = coverage_alpha(overlap(px, f->x, f->x + f->w) * cov_y);
+      if (j >= 0 && (px <= f->lx || px >= f->rx)) {
+        uint32_t arc = px <= f->lx ? corner_alpha(left, f->r, f->lx - px, j)
+                                   : corner_alpha(right, f->r, px - f->rx, j);
+        if (arc < a)
+          a = arc;
+      }
+      mask[k] = (uint8_t)a;
+    }
+    kernels->over_mask(row + px0, f->color, mask, n);
+    px0 += n;
+  }
+}
+
+/* [a, b) clipped to [lo, hi), empty at its start if nothing is left */
+static void clip_span(double a, double b, int lo, int hi, int *x0, int *x1) {
+  *x0 = a < lo ? lo : (a > hi ? hi : (int)a);
+  *x1 = b > hi ? hi : (b < *x0 ? *x0 : (int)b);
+}
+
+void blit_fill_rounded(BlitImage *dst, double x, double y, double w, double h,
+                       double r, double red, double green, double blue,
+                       double alpha) {
+  if (w <= 0 || h <= 0 || alpha <= 0)
+    return;
+  if (r > w / 2)
+    r = w / 2;
+  if (r > h / 2)
+    r = h / 2;
+  if (r < 0)
+    r = 0;
+
+  uint32_t a = (uint32_t)(alpha * 255 + 0.5);
+  uint32_t color = a << 24 | (uint32_t)(red * a + 0.5) << 16 |
+                   (uint32_t)(green * a + 0.5) << 8 |
+                   (uint32_t)(blue * a + 0.5);
+
+  int ix0 = (int)floor(x), ix1 = (int)ceil(x + w);
+  int iy0 = (int)floor(y), iy1 = (int)ceil(y + h);
+  if (ix0 < dst->x0)
+    ix0 = dst->x0;
+  if (ix1 > dst->x1)
+    ix1 = dst->x1;
+  if (iy0 < dst->y0)
+    iy0 = dst->y0;
+  if (iy1 > dst->y1)
+    iy1 = dst->y1;
+  if (ix0 >= ix1 || iy0 >= iy1)
+    return;
+
+  /* Corner centres */
+  double cx0 = x + r, cx1 = x + w - r;
+  double cy0 = y + r, cy1 = y + h - r;
+
+  /*
+   * Columns fully inside take the span kernel: between the corners in
+   * corner rows, between the straight edges in the others.
+   */
+  int mx0, mx1, sx0, sx1;
+  clip_span(ceil(fmax(x, cx0 - 0.5)), floor(fmin(x + w, cx1 + 0.5)), ix0,
+            ix1, &mx0, &mx1);
+  clip_span(ceil(x), floor(x + w), ix0, ix1, &sx0, &sx1);
+
+  /* Pixels whose centres lie outside the corner centres on both axes */
+  Fill f = {x, w, r, color, (int)ceil(cx0 - 0.5) - 1,
+            (int)floor(cx1 - 0.5) + 1};
+  int ty = (int)ceil(cy0 - 0.5) - 1, by = (int)floor(cy1 - 0.5) + 1;
+  double ldx = cx0 - (f.lx + 0.5), rdx = f.rx + 0.5 - cx1;
+  double tdy = cy0 - (ty + 0.5), bdy = by + 0.5 - cy1;
+  Corner corners[4] = {{corner_table(r, ldx, tdy), ldx, tdy},
+                       {corner_table(r, rdx, tdy), rdx, tdy},
+                       {corner_table(r, ldx, bdy), ldx, bdy},
+                       {corner_table(r, rdx, bdy), rdx, bdy}};
+
+  for (int py = iy0; py < iy1; py++) {
+    uint32_t *row = pixel_row(dst, py);
+    double cov_y = overlap(py, y, y + h);
+
+    /* Rows above the top corner centres or below the bottom ones */
+    int j = -1;
+    const Corner *left = NULL, *right = NULL;
+    if (py <= ty) {
+      j = ty - py;
+      left = &corners[0];
+      right = &corners[1];
+    } else if (py >= by) {
+      j = py - by;
+      left = &corners[2];
+      right = &corners[3];
+    }
+
+    int x0 = j >= 0 ? mx0 : sx0, x1 = j >= 0 ? mx1 : sx1;
+    fill_edge(row, ix0, x0, &f, cov_y, j, left, right);
+    if (x1 > x0)
+      kernels->over_solid(row + x0, scale_alpha(color, coverage_alpha(cov_y)),
+                          x1 - x0);
+    fill_edge(row, x1, ix1, &f, cov_y, j, left, right);
+  }
+}
@@ -0,0 +1,51 @@
+/* src/blit.h - Pixel kernels for the flat parts of a frame */
+#ifndef BLIT_H
+#define BLIT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Most pixels of a frame are flat rounded rectangles (panel, cards, stack
+ * shadows) and sprite blits, which need no path rasterizer. These kernels
+ * write premultiplied ARGB32 directly, with SSE2 and AVX2 spans picked at
+ * run time and a scalar fallback. Every variant gives the same pixels.
+ */
+
+/* Premultiplied ARGB32 pixels; only the clip [x0, x1) x [y0, y1) is written */
+typedef struct {
+  uint8_t *data;
+  int stride; /* Bytes per row */
+  int width;
+  int height;
+  int x0, y0, x1, y1;
+} BlitImage;
+
+/*
+ * Pick the fastest kernels this CPU runs, or the ones named by
+ * SNAPPY_SIMD (scalar, sse2, avx2) when set. Call before any worker
+ * thread blits.
+ */
+void blit_init(void);
+
+/* Switch to the named kernels; false, and no change, if the CPU lacks them */
+bool blit_use(const char *isa);
+
+/* Name of the kernels in use */
+const char *blit_isa(void);
+
+/* Replace dst's pixels under its clip with src's at the same position */
+void blit_copy(BlitImage *dst, const BlitImage *src);
+
+/* Composite all of src over dst with its top-left corner at (x, y) */
+void blit_over(BlitImage *dst, const BlitImage *src, int x, int y);
+
+/*
+ * Composite a rounded rectangle of one colour (straight, not premultiplied,
+ * components 0..1) over dst, with antialiased edges and corners.
+ */
+void blit_fill_rounded(BlitImage *dst, double x, double y, double w, double h,
+                       double r, double red, double green, double blue,
+                       double alpha);
+
+#endif /* BLIT_H */
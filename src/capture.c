@@ -0,0 +1,270 @@
+/* src/capture.c - Window preview capture (hyprland-toplevel-export) */
+#define _POSIX_C_SOURCE 200809L
+
+#include "capture.h"
+#include "hyprland-toplevel-export-v1-client-protocol.h"
+#include "render.h"
+#include "shm_pool.h"
+#include "thumbnail.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#define LOG(fmt, ...) fprintf(stderr, "[Capture] " fmt "\n", ##__VA_ARGS__)
+#define CAPTURE_QUEUE_SIZE 8
+#define ADDRESS_SIZE 32
+
+/*
+ * Frames are copied into one shm buffer that is kept between captures and
+ * only reallocated when the frame size or format changes.
+ */
+typedef struct {
+  struct wl_buffer *buffer;
+  void *data;
+  size_t size;
+  uint32_t format;
+  uint32_t width;
+  uint32_t height;
+  uint32_t stride;
+} CaptureBuffer;
+
+static struct hyprland_toplevel_export_manager_v1 *manager = NULL;
+static CaptureBuffer capture_buf = {0};
+
+/* Capture in flight (at most one) */
+static struct hyprland_toplevel_export_frame_v1 *frame = NULL;
+static char frame_address[ADDRESS_SIZE];
+static bool frame_has_shm = false;
+static bool frame_y_invert = false;
+static uint32_t frame_format, frame_width, frame_height, frame_stride;
+
+/* Windows waiting for a capture, oldest first */
+static char queue[CAPTURE_QUEUE_SIZE][ADDRESS_SIZE];
+static int queue_len = 0;
+
+static void start_next(void);
+
+static void buffer_release(void) {
+  if (capture_buf.buffer)
+    wl_buffer_destroy(capture_buf.buffer);
+  if (capture_buf.data)
+    munmap(capture_buf.data, capture_buf.size);
+  memset(&capture_buf, 0, sizeof(capture_buf));
+}
+
+static int buffer_ensure(void) {
+  if (capture_buf.buffer && capture_buf.format == frame_format &&
+      capture_buf.width == frame_width &&
+      capture_buf.height == frame_height &&
+      capture_buf.stride == frame_stride)
+    return 0;
+
+  buffer_release();
+  if (!shm)
+    return -1;
+
+  size_t size = (size_t)frame_stride * frame_height;
+  int fd = create_shm_file(size);
+  if (fd < 0)
+    return -1;
+
+  void *data = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (data == MAP_FAILED) {
+    close(fd);
+    return -1;
+  }
+
+  struct wl_shm_pool *pool = wl_shm_create_pool(shm, fd, size);
+  capture_buf.buffer = wl_shm_pool_create_buffer(
+      pool, 0, frame_width, frame_height, frame_stride, frame_format);
+  wl_shm_pool_destroy(pool);
+  close(fd);
+
+  capture_buf.data = data;
+  capture_buf.size = size;
+  capture_buf.format = frame_format;
+  capture_buf.width = frame_width;
+  capture_buf.height = frame_height;
+  capture_buf.stride = frame_stride;
+  return 0;
+}
+
+static void frame_finish(void) {
+  if (frame) {
+    hyprland_toplevel_export_frame_v1_destroy(frame);
+    frame = NULL;
+  }
+  start_next();
+}
+
+/* --- Frame Events --- */
+static void frame_buffer(void *data,
+                         struct hyprland_toplevel_export_frame_v1 *f,
+                         uint32_t format, uint32_t width, uint32_t height,
+                         uint32_t stride) {
+  (void)data;
+  (void)f;
+  if (frame_has_shm)
+    return;
+  if (format != WL_SHM_FORMAT_ARGB8888 && format != WL_SHM_FORMAT_XRGB8888)
+    return;
+  frame_has_shm = true;
+  frame_format = format;
+  frame_width = width;
+  frame_height = height;
+  frame_stride = stride;
+}
+
+static void frame_damage(void *data,
+                         struct hyprland_toplevel_export_frame_v1 *f,
+                         uint32_t x, uint32_t y, uint32_t width,
+                         uint32_t height) {
+  (void)data;
+  (void)f;
+  (void)x;
+  (void)y;
+  (void)width;
+  (void)height;
+}
+
+static void frame_flags(void *data, struct hyprland_toplevel_export_frame_v1 *f,
+                        uint32_t flags) {
+  (void)data;
+  (void)f;
+  frame_y_invert =
+      (flags & HYPRLAND_TOPLEVEL_EXPORT_FRAME_V1_FLAGS_Y_INVERT) != 0;
+}
+
+static void frame_ready(void *data, struct hyprland_toplevel_export_frame_v1 *f,
+                        uint32_t tv_sec_hi, uint32_t tv_sec_lo,
+                        uint32_t tv_nsec) {
+  (void)data;
+  (void)f;
+  (void)tv_sec_hi;
+  (void)tv_sec_lo;
+  (void)tv_nsec;
+  if (thumbs_store(frame_address, capture_buf.data, frame_width, frame_height,
+                   frame_stride, frame_y_invert,
+                   frame_format == WL_SHM_FORMAT_XRGB8888) < 0)
+    LOG("Failed to store preview for %s", frame_address);
+  frame_finish();
+}
+
+static void frame_failed(void *data,
+                         struct hyprland_toplevel_export_frame_v1 *f) {
+  (void)data;
+  (void)f;
+  LOG("Capture of %s failed", frame_address);
+  frame_finish();
+}
+
+static void frame_linux_dmabuf(void *data,
+                               struct hyprland_toplevel_export_frame_v1 *f,
+                               uint32_t format, uint32_t width,
+                               uint32_t height) {
+  (void)data;
+  (void)f;
+  (void)format;
+  (void)width;
+  (void)height;
+}
+
+static void frame_buffer_done(void *data,
+                              struct hyprland_toplevel_export_frame_v1 *f) {
+  (void)data;
+  if (!frame_has_shm || buffer_ensure() < 0) {
+    LOG("No usable shm buffer for %s", frame_address);
+    frame_finish();
+    return;
+  }
+  hyprland_toplevel_export_frame_v1_copy(f, capture_buf.buffer, 1);
+}
+
+static const struct hyprland_toplevel_export_frame_v1_listener frame_listener =
+    {
+        .buffer = frame_buffer,
+        .damage = frame_damage,
+        .flags = frame_flags,
+        .ready = frame_ready,
+        .failed = frame_failed,
+        .linux_dmabuf = frame_linux_dmabuf,
+        .buffer_done = frame_buffer_done,
+};
+
+/* --- Queue --- */
+static void start_next(void) {
+  while (!frame && manager && queue_len > 0) {
+    snprintf(frame_address, sizeof(frame_address), "%s", queue[0]);
+    memmove(&queue[0], &queue[1], (queue_len - 1) * sizeof(queue[0]));
+    queue_len--;
+
+    /* Hyprland takes the low 32 bits of the window address as handle */
+    uint32_t handle = (uint32_t)strtoull(frame_address, NULL, 16);
+    if (handle == 0)
+      continue;
+
+    frame_has_shm = false;
+    frame_y_invert = false;
+    frame = hyprland_toplevel_export_manager_v1_capture_toplevel(manager, 0,
+                                                                 handle);
+    if (frame)
+      hyprland_toplevel_export_frame_v1_add_listener(frame, &frame_listener,
+                                                     NULL);
+  }
+}
+
+void capture_init(struct hyprland_toplevel_export_manager_v1 *mgr) {
+  manager = mgr;
+  if (manager)
+    LOG("Window previews enabled");
+}
+
+bool capture_available(void) { return manager != NULL; }
+
+void capture_request(const char *address) {
+  if (!manager || !address || strncmp(address, "0x", 2) != 0 ||
+      strlen(address) >= ADDRESS_SIZE)
+    return;
+
+  for (int i = 0; i < queue_len; i++) {
+    if (strcmp(queue[i], address) == 0)
+      return;
+  }
+
+  if (queue_len == CAPTURE_QUEUE_SIZE) {
+    /* Oldest request is the least interesting one */
+    memmove(&queue[0], &queue[1], (queue_len - 1) * sizeof(queue[0]));
+    queue_len--;
+  }
+  strcpy(queue[queue_len++], address);
+  start_next();
+}
+
+void capture_forget(const char *address) {
+  if (!address)
+    return;
+  for (int i = 0; i < queue_len; i++) {
+    if (strcmp(queue[i], address) == 0) {
+      memmove(&queue[i], &queue[i + 1], (queue_len - i - 1) * sizeof(queue[0]));
+      queue_len--;
+      break;
+    }
+  }
+  thumbs_forget(address);
+}
+
+void capture_cleanup(void) {
+  queue_len = 0;
+  if (frame) {
+    hyprland_toplevel_export_frame_v1_destroy(frame);
+    frame = NULL;
+  }
+  buffer_release();
+  if (manager) {
+    hyprland_toplevel_export_manager_v1_destroy(manager);
+    manager = NULL;
+  }
+  thumbs_cleanup();
+}
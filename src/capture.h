@@ -0,0 +1,28 @@
+/* src/capture.h - Window preview capture (hyprland-toplevel-export) */
+#ifndef CAPTURE_H
+#define CAPTURE_H
+
+#include <stdbool.h>
+
+struct hyprland_toplevel_export_manager_v1;
+
+/* Start capturing with the compositor's export manager (NULL disables) */
+void capture_init(struct hyprland_toplevel_export_manager_v1 *manager);
+
+/* True when previews can be captured */
+bool capture_available(void);
+
+/*
+ * Queue a capture of the window with this Hyprland address. Captures run
+ * one at a time from the Wayland event loop and land in the thumbnail
+ * cache; nothing here ever waits on the compositor.
+ */
+void capture_request(const char *address);
+
+/* Forget queued work and the cached preview of a closed window */
+void capture_forget(const char *address);
+
+/* Cancel any capture in flight and release the manager */
+void capture_cleanup(void);
+
+#endif /* CAPTURE_H */
@@ -0,0 +1,348 @@
+/* src/clients_json.c - Streaming parser for Hyprland's j/clients reply */
+#define _POSIX_C_SOURCE 200809L
+
+#include "clients_json.h"
+#include <stdlib.h>
+#include <string.h>
+
+void clients_parser_init(ClientsParser *p, AppState *state) {
+  memset(p, 0, sizeof(*p));
+  p->state = state;
+  p->cur.focus_history_id = 9999;
+}
+
+static void clients_parser_reset_client(ClientsParser *p) {
+  window_info_free(&p->cur);
+  p->cur.focus_history_id = 9999;
+  p->has_workspace = false;
+}
+
+void clients_parser_free(ClientsParser *p) {
+  clients_parser_reset_client(p);
+  free(p->buf);
+  p->buf = NULL;
+}
+
+static int buf_push(ClientsParser *p, char c) {
+  if (p->len + 1 >= p->cap) {
+    size_t new_cap = p->cap ? p->cap * 2 : 256;
+    char *tmp = realloc(p->buf, new_cap);
+    if (!tmp)
+      return -1;
+    p->buf = tmp;
+    p->cap = new_cap;
+  }
+  p->buf[p->len++] = c;
+  return 0;
+}
+
+static int buf_push_utf8(ClientsParser *p, uint32_t cp) {
+  int rc = 0;
+  if (cp < 0x80) {
+    rc |= buf_push(p, (char)cp);
+  } else if (cp < 0x800) {
+    rc |= buf_push(p, (char)(0xC0 | (cp >> 6)));
+    rc |= buf_push(p, (char)(0x80 | (cp & 0x3F)));
+  } else if (cp < 0x10000) {
+    rc |= buf_push(p, (char)(0xE0 | (cp >> 12)));
+    rc |= buf_push(p, (char)(0x80 | ((cp >> 6) & 0x3F)));
+    rc |= buf_push(p, (char)(0x80 | (cp & 0x3F)));
+  } else {
+    rc |= buf_push(p, (char)(0xF0 | (cp >> 18)));
+    rc |= buf_push(p, (char)(0x80 | ((cp >> 12) & 0x3F)));
+    rc |= buf_push(p, (char)(0x80 | ((cp >> 6) & 0x3F)));
+    rc |= buf_push(p, (char)(0x80 | (cp & 0x3F)));
+  }
+  return rc;
+}
+
+static ClientKey lookup_key(const ClientsParser *p) {
+  const char *k = p->buf;
+  if (p->depth == 2) {
+    if (strcmp(k, "address") == 0)
+      return KEY_ADDRESS;
+    if (strcmp(k, "title") == 0)
+      return KEY_TITLE;
+    if (strcmp(k, "class") == 0)
+      return KEY_CLASS;
+    if (strcmp(k, "focusHistoryID") == 0)
+      return KEY_FOCUS;
+    if (strcmp(k, "floating") == 0)
+      return KEY_FLOATING;
+    if (strcmp(k, "workspace") == 0)
+      return KEY_WORKSPACE;
+  } else if (p->depth == 3 && p->keys[2] == KEY_WORKSPACE) {
+    if (strcmp(k, "id") == 0)
+      return KEY_WS_ID;
+  }
+  return KEY_NONE;
+}
+
+/* Is a key at the current depth one we care about? */
+static bool key_relevant(const ClientsParser *p) {
+  return p->depth == 2 || (p->depth == 3 && p->keys[2] == KEY_WORKSPACE);
+}
+
+static void set_string_field(char **field, const char *value) {
+  char *copy = strdup(value);
+  if (copy) {
+    free(*field);
+    *field = copy;
+  }
+}
+
+static void string_done(ClientsParser *p) {
+  p->in_string = false;
+  if (!p->capture)
+    goto out;
+  /* Push the terminator so an empty first string has a buffer too */
+  if (buf_push(p, '\0') < 0) {
+    p->error = true;
+    goto out;
+  }
+
+  if (p->expect_key) {
+    p->keys[p->depth] = lookup_key(p);
+    goto out;
+  }
+
+  if (p->depth == 2) {
+    switch (p->keys[2]) {
+    case KEY_ADDRESS:
+      set_string_field(&p->cur.address, p->buf);
+      break;
+    case KEY_TITLE:
+      set_string_field(&p->cur.title, p->buf);
+      break;
+    case KEY_CLASS:
+      set_string_field(&p->cur.class_name, p->buf);
+      break;
+    default:
+      break;
+    }
+  }
+
+out:
+  if (!p->expect_key && p->depth > 0)
+    p->keys[p->depth] = KEY_NONE;
+  p->capture = false;
+  p->len = 0;
+}
+
+static void scalar_done(ClientsParser *p) {
+  p->in_scalar = false;
+  p->scalar[p->scalar_len] = '\0';
+
+  if (p->depth == 2) {
+    if (p->keys[2] == KEY_FOCUS)
+      p->cur.focus_history_id = atoi(p->scalar);
+    else if (p->keys[2] == KEY_FLOATING)
+      p->cur.is_floating = (strcmp(p->scalar, "true") == 0);
+  } else if (p->depth == 3 && p->keys[3] == KEY_WS_ID) {
+    p->cur.workspace_id = atoi(p->scalar);
+    p->has_workspace = true;
+  }
+
+  if (p->depth > 0)
+    p->keys[p->depth] = KEY_NONE;
+  p->scalar_len = 0;
+}
+
+static void client_done(ClientsParser *p) {
+  if (p->has_workspace) {
+    WindowInfo info = p->cur;
+    info.address = app_state_strdup(p->state, p->cur.address);
+    info.title = app_state_strdup(p->state, p->cur.title);
+    info.class_name = app_state_strdup(p->state, p->cur.class_name);
+    info.class_atom = atom_intern(p->cur.class_name);
+    info.is_active = (info.focus_history_id == 0);
+    info.group_count = 1;
+    info.first_member = 0;
+    if (app_state_add(p->state, &info) < 0)
+      window_info_free(&info);
+  }
+  clients_parser_reset_client(p);
+}
+
+/* A high surrogate without its low half decodes to U+FFFD */
+static void lone_surrogate(ClientsParser *p) {
+  p->high_surrogate = 0;
+  if (buf_push_utf8(p, 0xFFFD) < 0)
+    p->error = true;
+}
+
+static void string_char(ClientsParser *p, char c) {
+  if (p->high_surrogate && p->unicode_left == 0 &&
+      (p->escape ? c != 'u' : c != '\\'))
+    lone_surrogate(p);
+
+  if (p->unicode_left > 0) {
+    int v;
+    if (c >= '0' && c <= '9')
+      v = c - '0';
+    else if (c >= 'a' && c <= 'f')
+      v = c - 'a' + 10;
+    else if (c >= 'A' && c <= 'F')
+      v = c - 'A' + 10;
+    else {
+      p->error = true;
+      return;
+    }
+    p->unicode = (p->unicode << 4) | v;
+    if (--p->unicode_left > 0 || !p->capture)
+      return;
+
+    uint32_t cp = p->unicode;
+    bool low = cp >= 0xDC00 && cp <= 0xDFFF;
+    if (p->high_surrogate && !low)
+      lone_surrogate(p);
+    if (cp >= 0xD800 && cp <= 0xDBFF) {
+      p->high_surrogate = cp; /* Wait for the low half */
+      return;
+    }
+    if (low && p->high_surrogate)
+      cp = 0x10000 + ((p->high_surrogate - 0xD800) << 10) + (cp - 0xDC00);
+    else if (low)
+      cp = 0xFFFD;
+    p->high_surrogate = 0;
+    if (buf_push_utf8(p, cp) < 0)
+      p->error = true;
+    return;
+  }
+
+  if (p->escape) {
+    p->escape = false;
+    char out;
+    switch (c) {
+    case 'u':
+      p->unicode_left = 4;
+      p->unicode = 0;
+      return;
+    case 'b':
+      out = '\b';
+      break;
+    case 'f':
+      out = '\f';
+      break;
+    case 'n':
+      out = '\n';
+      break;
+    case 'r':
+      out = '\r';
+      break;
+    case 't':
+      out = '\t';
+      break;
+    default:
+      out = c; /* \" \\ \/ */
+      break;
+    }
+    if (p->capture && buf_push(p, out) < 0)
+      p->error = true;
+    return;
+  }
+
+  if (c == '\\') {
+    p->escape = true;
+  } else if (c == '"') {
+    string_done(p);
+  } else if (p->capture && buf_push(p, c) < 0) {
+    p->error = true;
+  }
+}
+
+int clients_parser_feed(ClientsParser *p, const char *data, size_t len) {
+  for (size_t i = 0; i < len && !p->error; i++) {
+    char c = data[i];
+
+    if (p->in_string) {
+      string_char(p, c);
+      continue;
+    }
+
+    if (p->in_scalar) {
+      bool end = (c == ',' || c == ']' || c == '}' || c == ' ' || c == '\n' ||
+                  c == '\r' || c == '\t');
+      if (!end) {
+        if (p->scalar_len + 1 < sizeof(p->scalar))
+          p->scalar[p->scalar_len++] = c;
+        continue;
+      }
+      scalar_done(p);
+    }
+
+    switch (c) {
+    case ' ':
+    case '\n':
+    case '\r':
+    case '\t':
+    case ':':
+      if (c == ':')
+        p->expect_key = false;
+      break;
+    case '"':
+      p->in_string = true;
+      p->capture = p->expect_key
+                       ? key_relevant(p)
+                       : (p->depth == 2 && (p->keys[2] == KEY_ADDRESS ||
+                                            p->keys[2] == KEY_TITLE ||
+                                            p->keys[2] == KEY_CLASS));
+      p->len = 0;
+      p->high_surrogate = 0;
+      break;
+    case '[':
+    case '{':
+      if (p->depth == 0) {
+        if (c != '[' || p->seen_root) {
+          p->error = true;
+          break;
+        }
+        p->seen_root = true;
+      }
+      if (p->depth + 1 >= JSON_MAX_DEPTH) {
+        p->error = true;
+        break;
+      }
+      p->depth++;
+      p->is_object[p->depth] = (c == '{');
+      p->keys[p->depth] = KEY_NONE;
+      p->expect_key = (c == '{');
+      break;
+    case ']':
+    case '}':
+      if (p->depth == 0 || p->is_object[p->depth] != (c == '}')) {
+        p->error = true;
+        break;
+      }
+      if (c == '}' && p->depth == 2)
+        client_done(p);
+      p->depth--;
+      p->keys[p->depth] = KEY_NONE;
+      p->expect_key = false;
+      break;
+    case ',':
+      if (p->depth == 0) {
+        p->error = true;
+        break;
+      }
+      p->expect_key = p->is_object[p->depth];
+      break;
+    default:
+      if (p->depth == 0 || p->expect_key) {
+        p->error = true;
+        break;
+      }
+      p->in_scalar = true;
+      p->scalar_len = 0;
+      p->scalar[p->scalar_len++] = c;
+      break;
+    }
+  }
+  return p->error ? -1 : 0;
+}
+
+int clients_parser_finish(ClientsParser *p) {
+  if (p->error || !p->seen_root || p->depth != 0 || p->in_string)
+    return -1;
+  return 0;
+}
@@ -0,0 +1,73 @@
+/* src/clients_json.h - Streaming parser for Hyprland's j/clients reply */
+#ifndef CLIENTS_JSON_H
+#define CLIENTS_JSON_H
+
+#include "data.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Purpose-built incremental scanner for the j/clients array. It consumes the
+ * response chunk by chunk as it arrives from read() and emits a WindowInfo
+ * per client object, so no DOM is built and only the fields we use are
+ * copied. Strings we don't need are skipped without being stored.
+ */
+#define JSON_MAX_DEPTH 32
+
+typedef enum {
+  KEY_NONE,
+  KEY_ADDRESS,
+  KEY_TITLE,
+  KEY_CLASS,
+  KEY_FOCUS,
+  KEY_FLOATING,
+  KEY_WORKSPACE,
+  KEY_WS_ID
+} ClientKey;
+
+typedef struct {
+  AppState *state;
+
+  /* Container stack: true = object, false = array */
+  bool is_object[JSON_MAX_DEPTH];
+  ClientKey keys[JSON_MAX_DEPTH]; /* Key whose value is pending per depth */
+  int depth;
+  bool expect_key;
+  bool seen_root;
+  bool error;
+
+  /* String token */
+  bool in_string;
+  bool capture;
+  bool escape;
+  int unicode_left;
+  uint32_t unicode;
+  uint32_t high_surrogate;
+  char *buf;
+  size_t len;
+  size_t cap;
+
+  /* Scalar token (number / true / false / null) */
+  char scalar[32];
+  size_t scalar_len;
+  bool in_scalar;
+
+  /* Client object under construction (depth 2) */
+  WindowInfo cur;
+  bool has_workspace;
+} ClientsParser;
+
+/* Start parsing a reply whose clients are appended to state */
+void clients_parser_init(ClientsParser *p, AppState *state);
+
+/* Feed one chunk of the response; returns -1 on malformed input */
+int clients_parser_feed(ClientsParser *p, const char *data, size_t len);
+
+/* After the last chunk: -1 unless a complete array was parsed */
+int clients_parser_finish(ClientsParser *p);
+
+/* Release the parser's buffers (the parsed clients stay in state) */
+void clients_parser_free(ClientsParser *p);
+
+#endif /* CLIENTS_JSON_H */
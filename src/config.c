@@ -17,6 +17,9 @@
 static void set_defaults(Config *cfg) {
   cfg->mode = MODE_CONTEXT;
   cfg->follow_monitor = false;
+  cfg->prefetch_ttl_ms = 1000;
+  cfg->show_previews = false;
+  cfg->render_threads = 0;
 
   /* Default Theme Colors */
   cfg->background = 0x1e1e2e;
@@ -34,6 +37,7 @@ static void set_defaults(Config *cfg) {
   cfg->card_gap = 10;
   cfg->padding = 20;
   cfg->max_cols = 5;
+  cfg->max_rows = 0;
 
   /* Icons */
   cfg->icon_size = 56;
@@ -86,6 +90,13 @@ static void apply_value(Config *cfg, const char *section, const char *key,
     } else if (strcasecmp(key, "follow_monitor") == 0) {
       cfg->follow_monitor =
           (strcasecmp(val, "true") == 0 || strcmp(val, "1") == 0);
+    } else if (strcasecmp(key, "prefetch_ttl_ms") == 0) {
+      cfg->prefetch_ttl_ms = atoi(val);
+    } else if (strcasecmp(key, "show_previews") == 0) {
+      cfg->show_previews =
+          (strcasecmp(val, "true") == 0 || strcmp(val, "1") == 0);
+    } else if (strcasecmp(key, "render_threads") == 0) {
+      cfg->render_threads = atoi(val);
     }
   }
   /* Colors (from theme or manual override) */
@@ -120,6 +131,8 @@ static void apply_value(Config *cfg, const char *section, const char *key,
       cfg->padding = atoi(val);
     else if (strcasecmp(key, "max_cols") == 0)
       cfg->max_cols = atoi(val);
+    else if (strcasecmp(key, "max_rows") == 0)
+      cfg->max_rows = atoi(val);
     else if (strcasecmp(key, "icon_size") == 0)
       cfg->icon_size = atoi(val);
     else if (strcasecmp(key, "icon_radius") == 0)
@@ -341,6 +354,10 @@ Config *load_config(void) {
   return cfg;
 }
 
+int config_apply_file(Config *cfg, const char *path) {
+  return parse_ini_file(path, cfg, NULL, 0);
+}
+
 Config *get_default_config(void) {
   Config *cfg = malloc(sizeof(Config));
   if (cfg) {
@@ -29,6 +29,7 @@ typedef struct {
   int border_width;
   int padding;
   int max_cols;
+  int max_rows; /* Rows in view before the grid scrolls, 0 = all */
   int icon_size;
   int icon_radius;
 
@@ -46,6 +47,15 @@ typedef struct {
   /* View Mode */
   bool follow_monitor;
   ViewMode mode;
+
+  /* How long a PREFETCH result stays valid for the next show (ms) */
+  int prefetch_ttl_ms;
+
+  /* Show captured window previews on cards (Hyprland only) */
+  bool show_previews;
+
+  /* Threads drawing cards (0 = one per CPU, up to 4; 1 = daemon only) */
+  int render_threads;
 } Config;
 
 /* Load config from file, returns default if file not found */
@@ -57,6 +67,9 @@ void free_config(Config *config);
 /* Get default config (fallback values) */
 Config *get_default_config(void);
 
+/* Apply one config or theme file on top of config; -1 if unreadable */
+int config_apply_file(Config *config, const char *path);
+
 /* Helper: Convert uint32_t hex color to cairo RGB (0.0-1.0) */
 void color_to_rgb(uint32_t color, double *r, double *g, double *b);
 
@@ -0,0 +1,117 @@
+/* src/data.c - Window list storage shared by the backends */
+#define _POSIX_C_SOURCE 200809L
+
+#include "data.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define INITIAL_CAPACITY 32
+
+void app_state_init(AppState *state) {
+  state->windows = NULL;
+  state->count = 0;
+  state->capacity = 0;
+  state->selected_index = 0;
+  state->first_row = 0;
+  state->members = NULL;
+  state->member_count = 0;
+  state->width = 200; /* Default safe size */
+  state->height = 100;
+  state->snapshots[0].head = NULL;
+  state->snapshots[1].head = NULL;
+  state->current = 0;
+  state->arena_backed = false;
+}
+
+void window_info_free(WindowInfo *info) {
+  if (info) {
+    free(info->address);
+    free(info->title);
+    free(info->class_name);
+    memset(info, 0, sizeof(WindowInfo));
+  }
+}
+
+void app_state_free(AppState *state) {
+  if (state) {
+    if (state->arena_backed) {
+      arena_free(&state->snapshots[0]);
+      arena_free(&state->snapshots[1]);
+      state->arena_backed = false;
+    } else if (state->members) {
+      /* Cards alias member strings; members own them */
+      for (int i = 0; i < state->member_count; i++) {
+        window_info_free(&state->members[i]);
+      }
+      free(state->members);
+      free(state->windows);
+    } else if (state->windows) {
+      for (int i = 0; i < state->count; i++) {
+        window_info_free(&state->windows[i]);
+      }
+      free(state->windows);
+    }
+    state->windows = NULL;
+    state->count = 0;
+    state->capacity = 0;
+    state->members = NULL;
+    state->member_count = 0;
+  }
+}
+
+void app_state_begin_snapshot(AppState *state) {
+  if (!state->arena_backed) {
+    app_state_free(state);
+    state->arena_backed = true;
+  }
+
+  /* The previous snapshot stays valid until the one after this */
+  state->current ^= 1;
+  arena_reset(&state->snapshots[state->current]);
+
+  state->windows = NULL;
+  state->count = 0;
+  state->capacity = 0;
+  state->selected_index = 0;
+  state->first_row = 0;
+  state->members = NULL;
+  state->member_count = 0;
+}
+
+char *app_state_strdup(AppState *state, const char *str) {
+  if (state->arena_backed)
+    return arena_strdup(&state->snapshots[state->current], str);
+  return heap_strdup(str);
+}
+
+int app_state_reserve(AppState *state, int count) {
+  if (count <= state->capacity)
+    return 0;
+
+  WindowInfo *new_ptr;
+  if (state->arena_backed) {
+    /* Arena memory can't grow in place: copy into a fresh allocation */
+    new_ptr = arena_alloc(&state->snapshots[state->current],
+                          count * sizeof(WindowInfo));
+    if (new_ptr && state->count > 0)
+      memcpy(new_ptr, state->windows, state->count * sizeof(WindowInfo));
+  } else {
+    new_ptr = heap_realloc(state->windows, count * sizeof(WindowInfo));
+  }
+  if (!new_ptr)
+    return -1;
+
+  state->windows = new_ptr;
+  state->capacity = count;
+  return 0;
+}
+
+int app_state_add(AppState *state, WindowInfo *info) {
+  if (state->count >= state->capacity) {
+    int new_cap = state->capacity == 0 ? INITIAL_CAPACITY : state->capacity * 2;
+    if (app_state_reserve(state, new_cap) < 0)
+      return -1;
+  }
+  state->windows[state->count++] = *info;
+  return 0;
+}
@@ -2,6 +2,8 @@
 #ifndef DATA_H
 #define DATA_H
 
+#include "arena.h"
+#include "atoms.h"
 #include <stdbool.h>
 #include <stdint.h>
 
@@ -10,11 +12,13 @@ typedef struct {
   char *address;        /* Window address (hex string) */
   char *title;          /* Window title */
   char *class_name;     /* Application class name */
+  Atom class_atom;      /* Interned class_name */
   int workspace_id;     /* Workspace ID (-1 for special workspaces) */
   int focus_history_id; /* Focus history ID (0 = most recently focused) */
   bool is_active;       /* Whether this window is currently focused */
   bool is_floating;     /* Whether this window is floating (not tiled) */
   int group_count;      /* Number of windows in this group */
+  int first_member;     /* Index of the group's first entry in members[] */
 } WindowInfo;
 
 /* Application state */
@@ -23,10 +27,30 @@ typedef struct {
   int count;           /* Number of windows */
   int capacity;        /* Allocated capacity */
   int selected_index;  /* Currently selected window index */
+  int first_row;       /* First grid row in view when max_rows scrolls */
+
+  /*
+   * Context mode: every window, laid out group by group in MRU order.
+   * windows[i] covers members[first_member .. first_member + group_count).
+   * NULL when no grouping was done.
+   */
+  WindowInfo *members;
+  int member_count;
 
   /* UI Dimensions (Shared with Input/Render) */
   uint32_t width;
   uint32_t height;
+
+  /*
+   * Snapshot storage. Once app_state_begin_snapshot() has been called the
+   * windows array and all window strings live in snapshots[current], and
+   * the two arenas alternate so the previous snapshot stays intact while
+   * the next one is built. Otherwise (arena_backed == false) everything is
+   * individually malloc'd.
+   */
+  Arena snapshots[2];
+  int current;
+  bool arena_backed;
 } AppState;
 
 /* Initialize AppState */
@@ -34,10 +58,19 @@ void app_state_init(AppState *state);
 
 int app_state_add(AppState *state, WindowInfo *info);
 
+/* Ensure room for at least count windows */
+int app_state_reserve(AppState *state, int count);
+
+/* Copy a string into storage owned by the state (NULL becomes "") */
+char *app_state_strdup(AppState *state, const char *str);
+
+/* Switch to the other snapshot arena and empty the window list */
+void app_state_begin_snapshot(AppState *state);
+
 /* Free all resources held by AppState */
 void app_state_free(AppState *state);
 
-/* Free a single WindowInfo's strings */
+/* Free a single WindowInfo's strings (malloc-backed states only) */
 void window_info_free(WindowInfo *info);
 
 #endif /* DATA_H */
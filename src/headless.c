@@ -0,0 +1,117 @@
+/* src/headless.c - Offscreen output sink for the renderer */
+#include "headless.h"
+#include <cairo/cairo.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define LOG(fmt, ...) fprintf(stderr, "[Headless] " fmt "\n", ##__VA_ARGS__)
+
+typedef struct {
+  ShmBuffer pub; /* First, so a ShmBuffer * is also a Slot * */
+  size_t capacity;
+  bool held;  /* Owned by the renderer */
+  bool shown; /* Last presented; left alone until the next present */
+} Slot;
+
+static Slot slots[SHM_POOL_BUFFERS];
+static Slot *presented = NULL;
+
+static ShmBuffer *headless_acquire(uint32_t width, uint32_t height) {
+  if (width == 0 || height == 0)
+    return NULL;
+
+  Slot *slot = NULL;
+  for (int i = 0; i < SHM_POOL_BUFFERS; i++) {
+    if (slots[i].held || slots[i].shown)
+      continue;
+    /* Prefer a buffer that already has this size, like the shm pool */
+    if (!slot || (slots[i].pub.width == width && slots[i].pub.height == height))
+      slot = &slots[i];
+  }
+  if (!slot)
+    return NULL;
+
+  uint32_t stride = width * 4;
+  size_t size = (size_t)stride * height;
+  if (size > slot->capacity) {
+    void *data = realloc(slot->pub.data, size);
+    if (!data) {
+      LOG("Out of memory for a %ux%u frame", width, height);
+      return NULL;
+    }
+    slot->pub.data = data;
+    slot->capacity = size;
+  }
+
+  slot->pub.width = width;
+  slot->pub.height = height;
+  slot->pub.stride = stride;
+  slot->held = true;
+  return &slot->pub;
+}
+
+static void headless_release(ShmBuffer *buf) {
+  if (buf)
+    ((Slot *)buf)->held = false;
+}
+
+static void headless_present(ShmBuffer *buf, const RenderRect *damage,
+                             int n) {
+  (void)damage;
+  (void)n;
+  if (presented)
+    presented->shown = false;
+  presented = (Slot *)buf;
+  presented->shown = true;
+}
+
+const RenderSink headless_sink = {
+    .acquire = headless_acquire,
+    .release = headless_release,
+    .present = headless_present,
+};
+
+const ShmBuffer *headless_frame(void) {
+  return presented ? &presented->pub : NULL;
+}
+
+uint64_t headless_hash(void) {
+  uint64_t h = 14695981039346656037ull;
+  if (!presented)
+    return h;
+
+  const ShmBuffer *buf = &presented->pub;
+  for (uint32_t y = 0; y < buf->height; y++) {
+    const uint8_t *row = (const uint8_t *)buf->data + (size_t)y * buf->stride;
+    for (uint32_t x = 0; x < buf->width * 4; x++) {
+      h ^= row[x];
+      h *= 1099511628211ull;
+    }
+  }
+  return h;
+}
+
+int headless_write_png(const char *path) {
+  if (!presented)
+    return -1;
+
+  const ShmBuffer *buf = &presented->pub;
+  cairo_surface_t *surf = cairo_image_surface_create_for_data(
+      buf->data, CAIRO_FORMAT_ARGB32, buf->width, buf->height, buf->stride);
+  cairo_status_t status = cairo_surface_write_to_png(surf, path);
+  cairo_surface_destroy(surf);
+  if (status != CAIRO_STATUS_SUCCESS) {
+    LOG("Failed to write %s: %s", path, cairo_status_to_string(status));
+    return -1;
+  }
+  return 0;
+}
+
+void headless_cleanup(void) {
+  for (int i = 0; i < SHM_POOL_BUFFERS; i++) {
+    free(slots[i].pub.data);
+    slots[i] = (Slot){0};
+  }
+  presented = NULL;
+}
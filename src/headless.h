@@ -0,0 +1,28 @@
+/* src/headless.h - Offscreen output sink for the renderer */
+#ifndef HEADLESS_H
+#define HEADLESS_H
+
+#include "render.h"
+#include <stdint.h>
+
+/*
+ * Frames rendered into plain memory instead of shm buffers. Presenting a
+ * frame only keeps it (as a compositor keeps the buffer on screen until
+ * the next commit), so render_ui() runs its full and partial paths
+ * exactly as on a live surface. Install with render_set_sink().
+ */
+extern const RenderSink headless_sink;
+
+/* Last presented frame, NULL before the first */
+const ShmBuffer *headless_frame(void);
+
+/* FNV-1a over the last presented frame's pixels, row by row */
+uint64_t headless_hash(void);
+
+/* Write the last presented frame to a PNG file; 0 on success */
+int headless_write_png(const char *path);
+
+/* Free all buffers */
+void headless_cleanup(void);
+
+#endif /* HEADLESS_H */
@@ -2,98 +2,112 @@
 #define _POSIX_C_SOURCE 200809L
 
 #include "hyprland.h"
+#include "capture.h"
+#include "clients_json.h"
 #include "config.h"
+#include "ipc_trace.h"
 #include <errno.h>
-#include <json-c/json.h>
+#include <fcntl.h>
+#include <poll.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/socket.h>
+#include <sys/time.h>
 #include <sys/un.h>
+#include <time.h>
 #include <unistd.h>
 
 #define LOG(fmt, ...) fprintf(stderr, "[Hyprland] " fmt "\n", ##__VA_ARGS__)
 #define BUFFER_SIZE 65536
-#define INITIAL_CAPACITY 32
+#define EVENT_BUFFER_SIZE 8192
 
-static char *get_socket_path(void);
+#define MAX_PENDING_REPLIES 8
+#define IPC_TIMEOUT_MS 500
+#define PREVIEW_SEED_COUNT 8
+#define BATCH_PREFIX "[[BATCH]]"
+
+/* Hyprland sockets, resolved once at init */
+typedef enum { SOCKET_REQUEST, SOCKET_EVENTS, SOCKET_COUNT } HyprSocket;
+static const char *socket_names[SOCKET_COUNT] = {".socket.sock",
+                                                 ".socket2.sock"};
+static struct sockaddr_un socket_addrs[SOCKET_COUNT];
+static bool socket_addrs_ready = false;
+
+/* Replies of fire-and-forget commands, drained from the event loop */
+typedef struct {
+  int fd;
+  long long trace_start; /* Only used while recording an IPC trace */
+  TraceBuf trace_request;
+  TraceBuf trace_response;
+} PendingReply;
+
+static PendingReply pending_replies[MAX_PENDING_REPLIES];
+static int pending_count = 0;
+
+static int resolve_socket_addrs(void);
+static void drain_replies(void);
+static void pending_close(PendingReply *reply, bool complete);
+static int events_connect(void);
+static void events_disconnect(void);
+static int model_resync(void);
+static int fetch_wait(void);
+static void fetch_abort(const char *reason);
+
+/*
+ * Event-driven window model.
+ * Windows are kept in MRU order (index 0 = most recently focused) and are
+ * updated from the .socket2.sock event stream. A full j/clients resync is
+ * only needed at startup, after the stream breaks, or when an event leaves
+ * out state the model needs, as openwindow does for floating
+ * (model_synced == false).
+ */
+static AppState model;
+static int event_fd = -1;
+static bool model_synced = false;
+static uint64_t model_generation = 0; /* Bumped on every model change */
+static char event_buf[EVENT_BUFFER_SIZE];
+static size_t event_len = 0;
+static bool saw_title_v2 = false; /* windowtitlev2 supersedes windowtitle */
+static bool saw_move_v2 = false;  /* movewindowv2 supersedes movewindow */
 
 int hyprland_backend_init(void) {
-  /* Hyprland backend doesn't need special initialization */
-  /* Just check if we can connect */
-  char *socket_path = get_socket_path();
-  if (!socket_path) {
+  if (resolve_socket_addrs() < 0) {
     LOG("HYPRLAND_INSTANCE_SIGNATURE or XDG_RUNTIME_DIR not set");
     return -1;
   }
 
   /* Test if socket exists */
-  if (access(socket_path, F_OK) != 0) {
-    free(socket_path);
+  if (access(socket_addrs[SOCKET_REQUEST].sun_path, F_OK) != 0) {
     LOG("Hyprland socket not found");
     return -1;
   }
 
-  free(socket_path);
+  app_state_init(&model);
+  ipc_trace_init();
+
+  /* Subscribe before the initial fetch so no event falls in between */
+  if (events_connect() < 0)
+    LOG("Event socket unavailable, falling back to per-show fetch");
+  if (model_resync() < 0 || fetch_wait() < 0)
+    LOG("Initial window fetch failed, will retry on show");
+
   return 0;
 }
 
 void hyprland_backend_cleanup(void) {
-  /* Nothing to cleanup for Hyprland backend */
+  for (int i = 0; i < pending_count; i++)
+    pending_close(&pending_replies[i], false);
+  pending_count = 0;
+  fetch_abort("cancelled");
+  events_disconnect();
+  ipc_trace_close();
+  app_state_free(&model);
+  model_synced = false;
 }
 
 const char *hyprland_get_name(void) { return "hyprland"; }
 
-/* --- Memory Management --- */
-void app_state_init(AppState *state) {
-  state->windows = NULL;
-  state->count = 0;
-  state->capacity = 0;
-  state->selected_index = 0;
-  state->width = 200; /* Default safe size */
-  state->height = 100;
-}
-
-void window_info_free(WindowInfo *info) {
-  if (info) {
-    free(info->address);
-    free(info->title);
-    free(info->class_name);
-    memset(info, 0, sizeof(WindowInfo));
-  }
-}
-
-void app_state_free(AppState *state) {
-  if (state) {
-    if (state->windows) {
-      for (int i = 0; i < state->count; i++) {
-        window_info_free(&state->windows[i]);
-      }
-      free(state->windows);
-    }
-    state->windows = NULL;
-    state->count = 0;
-    state->capacity = 0;
-  }
-}
-
-static char *safe_strdup(const char *str) {
-  return str ? strdup(str) : strdup("");
-}
-
-int app_state_add(AppState *state, WindowInfo *info) {
-  if (state->count >= state->capacity) {
-    int new_cap = state->capacity == 0 ? INITIAL_CAPACITY : state->capacity * 2;
-    WindowInfo *new_ptr = realloc(state->windows, new_cap * sizeof(WindowInfo));
-    if (!new_ptr)
-      return -1;
-    state->windows = new_ptr;
-    state->capacity = new_cap;
-  }
-  state->windows[state->count++] = *info;
-  return 0;
-}
-
 /* --- Sorting (Stable MRU) --- */
 static int compare_mru(const void *a, const void *b) {
   const WindowInfo *wa = (const WindowInfo *)a;
@@ -109,169 +123,826 @@ static int compare_mru(const void *a, const void *b) {
 }
 
 /* --- IPC --- */
-static char *get_socket_path(void) {
+static int resolve_socket_addrs(void) {
   const char *sig = getenv("HYPRLAND_INSTANCE_SIGNATURE");
   const char *xdg = getenv("XDG_RUNTIME_DIR");
   if (!sig || !xdg)
-    return NULL;
+    return -1;
 
-  size_t len = strlen(xdg) + strlen(sig) + 32;
-  char *path = malloc(len);
-  if (path)
-    snprintf(path, len, "%s/hypr/%s/.socket.sock", xdg, sig);
-  return path;
+  for (int i = 0; i < SOCKET_COUNT; i++) {
+    struct sockaddr_un *addr = &socket_addrs[i];
+    memset(addr, 0, sizeof(*addr));
+    addr->sun_family = AF_UNIX;
+    snprintf(addr->sun_path, sizeof(addr->sun_path), "%s/hypr/%s/%s", xdg,
+             sig, socket_names[i]);
+  }
+  socket_addrs_ready = true;
+  return 0;
 }
 
-static char *hyprland_request(const char *cmd) {
-  char *path = get_socket_path();
-  if (!path)
-    return NULL;
-
-  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
-  if (fd < 0) {
-    free(path);
-    return NULL;
-  }
+/*
+ * Connect to a Hyprland socket. The connect never waits (a full backlog
+ * fails at once). Sockets left blocking get IPC_TIMEOUT_MS send/receive
+ * timeouts so no call can hang on a stalled compositor.
+ */
+static int connect_socket(HyprSocket which, bool nonblock) {
+  if (!socket_addrs_ready && resolve_socket_addrs() < 0)
+    return -1;
 
-  struct sockaddr_un addr = {0};
-  addr.sun_family = AF_UNIX;
-  strncpy(addr.sun_path, path, sizeof(addr.sun_path) - 1);
-  free(path);
+  int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+  if (fd < 0)
+    return -1;
 
-  if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+  if (connect(fd, (struct sockaddr *)&socket_addrs[which],
+              sizeof(socket_addrs[which])) < 0) {
     close(fd);
-    return NULL;
+    return -1;
   }
 
-  if (write(fd, cmd, strlen(cmd)) < 0) {
-    close(fd);
-    return NULL;
+  if (!nonblock) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    if (flags >= 0)
+      fcntl(fd, F_SETFL, flags & ~O_NONBLOCK);
+    struct timeval tv = {.tv_sec = IPC_TIMEOUT_MS / 1000,
+                         .tv_usec = (IPC_TIMEOUT_MS % 1000) * 1000};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+  }
+  return fd;
+}
+
+static int write_all(int fd, const char *buf, size_t len) {
+  while (len > 0) {
+    ssize_t n = write(fd, buf, len);
+    if (n < 0) {
+      if (errno == EINTR)
+        continue;
+      return -1;
+    }
+    buf += n;
+    len -= n;
   }
+  return 0;
+}
 
+static char *read_reply(int fd) {
   size_t capacity = BUFFER_SIZE;
   char *resp = malloc(capacity);
+  if (!resp)
+    return NULL;
   size_t total = 0;
   ssize_t n;
 
-  while ((n = read(fd, resp + total, capacity - total - 1)) > 0) {
+  while ((n = read(fd, resp + total, capacity - total - 1)) != 0) {
+    if (n < 0) {
+      if (errno == EINTR)
+        continue;
+      break;
+    }
     total += n;
     if (total >= capacity - 1) {
       capacity *= 2;
       char *tmp = realloc(resp, capacity);
       if (!tmp) {
         free(resp);
-        close(fd);
         return NULL;
       }
       resp = tmp;
     }
   }
   resp[total] = '\0';
+  return resp;
+}
+
+/* Close a parked reply, recording it first when tracing */
+static void pending_close(PendingReply *reply, bool complete) {
+  if (complete && ipc_trace_enabled()) {
+    ipc_trace_record(reply->trace_start, reply->trace_request.data,
+                     reply->trace_request.len, reply->trace_response.data,
+                     reply->trace_response.len);
+  }
+  trace_buf_free(&reply->trace_request);
+  trace_buf_free(&reply->trace_response);
+  close(reply->fd);
+}
+
+/* Park a reply fd to be drained by hyprland_dispatch_events() */
+static void defer_reply(int fd, const char *request, size_t len,
+                        long long start) {
+  if (pending_count == MAX_PENDING_REPLIES) {
+    /* Oldest reply is long overdue; stop waiting for it */
+    pending_close(&pending_replies[0], true);
+    memmove(&pending_replies[0], &pending_replies[1],
+            (MAX_PENDING_REPLIES - 1) * sizeof(PendingReply));
+    pending_count--;
+  }
+
+  int flags = fcntl(fd, F_GETFL, 0);
+  if (flags >= 0)
+    fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+
+  PendingReply *reply = &pending_replies[pending_count++];
+  memset(reply, 0, sizeof(*reply));
+  reply->fd = fd;
+  reply->trace_start = start;
+  if (ipc_trace_enabled())
+    trace_buf_append(&reply->trace_request, request, len);
+}
+
+static void drain_replies(void) {
+  char buf[512];
+  int kept = 0;
+
+  for (int i = 0; i < pending_count; i++) {
+    PendingReply *reply = &pending_replies[i];
+    bool done = false;
+
+    while (1) {
+      ssize_t n = read(reply->fd, buf, sizeof(buf));
+      if (n > 0) {
+        if (ipc_trace_enabled())
+          trace_buf_append(&reply->trace_response, buf, n);
+        continue;
+      }
+      if (n < 0 && errno == EINTR)
+        continue;
+      /* EOF or error ends the reply; EAGAIN means more is on the way */
+      done = !(n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK));
+      break;
+    }
+
+    if (done)
+      pending_close(reply, true);
+    else
+      pending_replies[kept++] = *reply;
+  }
+  pending_count = kept;
+}
+
+/*
+ * Send one or more commands over a single connection. Several commands are
+ * joined into a [[BATCH]] request so Hyprland runs them back to back. With
+ * wait == false the call returns as soon as the request is written and the
+ * reply is drained later from the event loop; the return value is then
+ * always NULL. With wait == true the reply is returned (caller frees); it
+ * is cut short if Hyprland stalls for more than IPC_TIMEOUT_MS.
+ */
+char *hyprland_command(const char *const *cmds, int count, bool wait) {
+  if (count <= 0)
+    return NULL;
+
+  char buf[1024];
+  size_t len = 0;
+  if (count > 1)
+    len = snprintf(buf, sizeof(buf), "%s", BATCH_PREFIX);
+  for (int i = 0; i < count && len < sizeof(buf); i++) {
+    len += snprintf(buf + len, sizeof(buf) - len, "%s%s", i > 0 ? ";" : "",
+                    cmds[i]);
+  }
+  if (len >= sizeof(buf)) {
+    LOG("Command too long, dropped");
+    return NULL;
+  }
+
+  long long start = ipc_trace_now_us();
+  int fd = connect_socket(SOCKET_REQUEST, false);
+  if (fd < 0)
+    return NULL;
+
+  if (write_all(fd, buf, len) < 0) {
+    close(fd);
+    return NULL;
+  }
+
+  if (!wait) {
+    defer_reply(fd, buf, len, start);
+    return NULL;
+  }
+
+  char *resp = read_reply(fd);
   close(fd);
+  if (ipc_trace_enabled())
+    ipc_trace_record(start, buf, len, resp, resp ? strlen(resp) : 0);
   return resp;
 }
 
-/* --- JSON Parsing --- */
-static int parse_clients(const char *json_str, AppState *state) {
-  struct json_object *root = json_tokener_parse(json_str);
-  if (!root || !json_object_is_type(root, json_type_array)) {
-    if (root)
-      json_object_put(root);
-    return -1;
+/* --- Window List Fetch --- */
+
+/*
+ * Non-blocking j/clients request, driven from the daemon's poll loop: the
+ * request is written and the reply parsed as the socket becomes ready, so a
+ * stalled compositor never holds up input or socket commands. A fetch that
+ * misses its deadline is dropped and the previous model is kept.
+ */
+typedef enum { FETCH_IDLE, FETCH_WRITING, FETCH_READING } FetchPhase;
+
+static struct {
+  FetchPhase phase;
+  int fd;
+  size_t written;
+  long long deadline; /* CLOCK_MONOTONIC, ms */
+  AppState result;
+  ClientsParser parser;
+  long long trace_start; /* Only used while recording an IPC trace */
+  TraceBuf trace_response;
+} fetch = {.phase = FETCH_IDLE, .fd = -1};
+
+static const char fetch_request[] = "j/clients";
+
+static long long now_ms(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+/* Record the exchange (complete or not) when tracing */
+static void fetch_trace(void) {
+  if (ipc_trace_enabled()) {
+    ipc_trace_record(fetch.trace_start, fetch_request,
+                     sizeof(fetch_request) - 1, fetch.trace_response.data,
+                     fetch.trace_response.len);
   }
+  trace_buf_free(&fetch.trace_response);
+}
 
-  size_t len = json_object_array_length(root);
-  for (size_t i = 0; i < len; i++) {
-    struct json_object *obj = json_object_array_get_idx(root, i);
-    struct json_object *ws_obj, *ws_id, *addr, *title, *cls, *focus, *floating;
+static void fetch_abort(const char *reason) {
+  if (fetch.phase == FETCH_IDLE)
+    return;
+  LOG("Window fetch %s, keeping previous list", reason);
+  fetch_trace();
+  close(fetch.fd);
+  fetch.fd = -1;
+  clients_parser_free(&fetch.parser);
+  app_state_free(&fetch.result);
+  fetch.phase = FETCH_IDLE;
+}
 
-    if (!json_object_object_get_ex(obj, "workspace", &ws_obj))
-      continue;
-    if (!json_object_object_get_ex(ws_obj, "id", &ws_id))
-      continue;
+static int fetch_start(void) {
+  if (fetch.phase != FETCH_IDLE)
+    return 0;
 
-    int wid = json_object_get_int(ws_id);
-    if (wid < 0)
-      continue;
+  long long start = ipc_trace_now_us();
+  int fd = connect_socket(SOCKET_REQUEST, true);
+  if (fd < 0) {
+    LOG("Failed to connect for j/clients");
+    return -1;
+  }
 
-    json_object_object_get_ex(obj, "address", &addr);
-    json_object_object_get_ex(obj, "title", &title);
-    json_object_object_get_ex(obj, "class", &cls);
-    json_object_object_get_ex(obj, "focusHistoryID", &focus);
-    json_object_object_get_ex(obj, "floating", &floating);
+  fetch.trace_start = start;
+  fetch.fd = fd;
+  fetch.written = 0;
+  fetch.deadline = now_ms() + IPC_TIMEOUT_MS;
+  app_state_init(&fetch.result);
+  clients_parser_init(&fetch.parser, &fetch.result);
+  fetch.phase = FETCH_WRITING;
+  return 0;
+}
 
-    WindowInfo info;
-    info.address = safe_strdup(json_object_get_string(addr));
-    info.title = safe_strdup(json_object_get_string(title));
-    info.class_name = safe_strdup(json_object_get_string(cls));
-    info.workspace_id = wid;
-    info.focus_history_id = focus ? json_object_get_int(focus) : 9999;
-    info.is_active = (info.focus_history_id == 0);
-    info.is_floating = floating ? json_object_get_boolean(floating) : false;
-    info.group_count = 1;
+/* Reply complete: adopt it as the new model */
+static int fetch_finish(void) {
+  fetch_trace();
+  close(fetch.fd);
+  fetch.fd = -1;
+  int rc = clients_parser_finish(&fetch.parser);
+  clients_parser_free(&fetch.parser);
+  fetch.phase = FETCH_IDLE;
+
+  if (rc < 0) {
+    LOG("Failed to parse j/clients");
+    app_state_free(&fetch.result);
+    return -1;
+  }
 
-    app_state_add(state, &info);
+  app_state_free(&model);
+  model = fetch.result;
+  model_generation++;
+  if (model.count > 1) {
+    qsort(model.windows, model.count, sizeof(WindowInfo), compare_mru);
   }
 
-  json_object_put(root);
+  /* Without a live event stream the model goes stale immediately */
+  model_synced = (event_fd >= 0);
+  LOG("Resynced window model: %d windows", model.count);
+  hyprland_request_previews();
   return 0;
 }
 
+/*
+ * Advance the fetch as far as the socket allows without blocking.
+ * Returns 1 once a new model is adopted, 0 while in flight or idle, -1 if
+ * the fetch failed.
+ */
+static int fetch_step(void) {
+  if (fetch.phase == FETCH_IDLE)
+    return 0;
+
+  if (fetch.phase == FETCH_WRITING) {
+    size_t len = sizeof(fetch_request) - 1;
+    while (fetch.written < len) {
+      ssize_t n = write(fetch.fd, fetch_request + fetch.written,
+                        len - fetch.written);
+      if (n < 0) {
+        if (errno == EINTR)
+          continue;
+        if (errno == EAGAIN || errno == EWOULDBLOCK)
+          return 0;
+        fetch_abort("write failed");
+        return -1;
+      }
+      fetch.written += n;
+    }
+    fetch.phase = FETCH_READING;
+  }
+
+  static char chunk[BUFFER_SIZE];
+  while (1) {
+    ssize_t n = read(fetch.fd, chunk, sizeof(chunk));
+    if (n > 0) {
+      if (ipc_trace_enabled())
+        trace_buf_append(&fetch.trace_response, chunk, n);
+      if (clients_parser_feed(&fetch.parser, chunk, n) < 0) {
+        fetch_abort("got malformed JSON");
+        return -1;
+      }
+      continue;
+    }
+    if (n == 0)
+      return fetch_finish() < 0 ? -1 : 1;
+    if (errno == EINTR)
+      continue;
+    if (errno == EAGAIN || errno == EWOULDBLOCK)
+      return 0;
+    fetch_abort("read failed");
+    return -1;
+  }
+}
+
+/* Drop the fetch if it is past its deadline */
+static void fetch_check_deadline(void) {
+  if (fetch.phase != FETCH_IDLE && now_ms() >= fetch.deadline)
+    fetch_abort("timed out");
+}
+
+/* Run the fetch to completion or its deadline (startup only) */
+static int fetch_wait(void) {
+  while (fetch.phase != FETCH_IDLE) {
+    int rc = fetch_step();
+    if (rc != 0)
+      return rc > 0 ? 0 : -1;
+
+    long long left = fetch.deadline - now_ms();
+    if (left <= 0) {
+      fetch_abort("timed out");
+      return -1;
+    }
+    struct pollfd pfd = {
+        .fd = fetch.fd,
+        .events = fetch.phase == FETCH_WRITING ? POLLOUT : POLLIN};
+    if (poll(&pfd, 1, (int)left) < 0 && errno != EINTR) {
+      fetch_abort("poll failed");
+      return -1;
+    }
+  }
+  return -1;
+}
+
 /* --- Aggregation (Context Mode) --- */
+
+/* Open-addressing table slot keyed by (workspace_id, class atom) */
+typedef struct {
+  int group; /* -1 = empty */
+  int workspace_id;
+  Atom class_atom;
+} GroupSlot;
+
+/* Scratch memory: from the snapshot arena, or the heap for malloc states */
+static void *scratch_alloc(AppState *state, size_t size) {
+  if (state->arena_backed)
+    return arena_alloc(&state->snapshots[state->current], size);
+  return heap_alloc(size);
+}
+
+static void scratch_free(AppState *state, void *ptr) {
+  if (!state->arena_backed)
+    free(ptr);
+}
+
+/*
+ * Group tiled windows by (workspace, class) in linear time. Groups are
+ * numbered in order of their first (most recent) member, so MRU order is
+ * preserved both between cards and within each group. The full member list
+ * is kept in state->members; each card is its group's first member.
+ */
 static void aggregate_context(AppState *state) {
-  if (state->count <= 1)
+  int count = state->count;
+  if (count <= 1)
     return;
 
-  int count = state->count;
-  WindowInfo *out = malloc(count * sizeof(WindowInfo));
-  int out_count = 0;
+  int slots = 16;
+  while (slots < count * 2)
+    slots <<= 1;
+
+  GroupSlot *table = scratch_alloc(state, slots * sizeof(GroupSlot));
+  int *group_of = scratch_alloc(state, count * sizeof(int));
+  int *group_start = scratch_alloc(state, (count + 1) * sizeof(int));
+  WindowInfo *members = scratch_alloc(state, count * sizeof(WindowInfo));
+  if (!table || !group_of || !group_start || !members) {
+    scratch_free(state, table);
+    scratch_free(state, group_of);
+    scratch_free(state, group_start);
+    scratch_free(state, members);
+    return;
+  }
+
+  for (int i = 0; i < slots; i++)
+    table[i].group = -1;
+  memset(group_start, 0, (count + 1) * sizeof(int));
 
+  /* Pass 1: assign a group to every window, counting members */
+  int groups = 0;
   for (int i = 0; i < count; i++) {
     WindowInfo *win = &state->windows[i];
 
     if (win->is_floating) {
-      out[out_count].address = safe_strdup(win->address);
-      out[out_count].title = safe_strdup(win->title);
-      out[out_count].class_name = safe_strdup(win->class_name);
-      out[out_count].workspace_id = win->workspace_id;
-      out[out_count].focus_history_id = win->focus_history_id;
-      out[out_count].is_active = win->is_active;
-      out[out_count].is_floating = true;
-      out[out_count].group_count = 1;
-      out_count++;
+      group_of[i] = groups++; /* Floating windows are never grouped */
+      group_start[group_of[i] + 1]++;
+      continue;
+    }
+
+    uint32_t h = (win->class_atom * 0x85EBCA6Bu) ^
+                 ((uint32_t)win->workspace_id * 0x9E3779B1u);
+    h ^= h >> 16;
+    int mask = slots - 1;
+    int idx = h & mask;
+    while (table[idx].group >= 0) {
+      GroupSlot *slot = &table[idx];
+      if (slot->class_atom == win->class_atom &&
+          slot->workspace_id == win->workspace_id)
+        break;
+      idx = (idx + 1) & mask;
+    }
+
+    if (table[idx].group < 0) {
+      table[idx].group = groups++;
+      table[idx].workspace_id = win->workspace_id;
+      table[idx].class_atom = win->class_atom;
+    }
+    group_of[i] = table[idx].group;
+    group_start[group_of[i] + 1]++;
+  }
+
+  /* Pass 2: prefix sums, then scatter members group by group (stable) */
+  for (int g = 0; g < groups; g++)
+    group_start[g + 1] += group_start[g];
+
+  for (int i = 0; i < count; i++) {
+    int g = group_of[i];
+    members[group_start[g]++] = state->windows[i];
+  }
+
+  /* group_start[g] now holds the end of group g; shift back to starts */
+  for (int g = groups; g > 0; g--)
+    group_start[g] = group_start[g - 1];
+  group_start[0] = 0;
+
+  /* Pass 3: the card for each group is its first member */
+  for (int g = 0; g < groups; g++) {
+    int first = group_start[g];
+    int size = group_start[g + 1] - first;
+    members[first].first_member = first;
+    members[first].group_count = size;
+    state->windows[g] = members[first];
+    for (int m = first + 1; m < first + size; m++) {
+      members[m].first_member = first;
+      members[m].group_count = size;
+    }
+  }
+
+  state->members = members;
+  state->member_count = count;
+  state->count = groups;
+
+  scratch_free(state, table);
+  scratch_free(state, group_of);
+  scratch_free(state, group_start);
+}
+
+/* --- Window Model --- */
+static int model_find(const char *address) {
+  for (int i = 0; i < model.count; i++) {
+    if (strcmp(model.windows[i].address, address) == 0)
+      return i;
+  }
+  return -1;
+}
+
+/* Event addresses lack the "0x" prefix that j/clients reports */
+static void format_address(char *out, size_t size, const char *addr,
+                           size_t len) {
+  if (len >= 2 && addr[0] == '0' && addr[1] == 'x')
+    snprintf(out, size, "%.*s", (int)len, addr);
+  else
+    snprintf(out, size, "0x%.*s", (int)len, addr);
+}
+
+/* Map a workspace name to its id; returns false if the name is not numeric */
+static bool workspace_from_name(const char *name, int *id) {
+  if (strncmp(name, "special", 7) == 0) {
+    *id = -1;
+    return true;
+  }
+  char *end;
+  long v = strtol(name, &end, 10);
+  if (end == name || *end != '\0')
+    return false;
+  *id = (int)v;
+  return true;
+}
+
+static void model_move_to_front(int idx) {
+  if (idx <= 0)
+    return;
+  WindowInfo win = model.windows[idx];
+  memmove(&model.windows[1], &model.windows[0], idx * sizeof(WindowInfo));
+  model.windows[0] = win;
+}
+
+static void model_remove(int idx) {
+  window_info_free(&model.windows[idx]);
+  memmove(&model.windows[idx], &model.windows[idx + 1],
+          (model.count - idx - 1) * sizeof(WindowInfo));
+  model.count--;
+}
+
+static void model_set_active(const char *address) {
+  /* Refresh previews of the windows losing and gaining focus */
+  if (model.count > 0 && model.windows[0].is_active)
+    capture_request(model.windows[0].address);
+  if (address[0])
+    capture_request(address);
+
+  for (int i = 0; i < model.count; i++)
+    model.windows[i].is_active = false;
+
+  int idx = address[0] ? model_find(address) : -1;
+  if (idx >= 0) {
+    model.windows[idx].is_active = true;
+    model_move_to_front(idx);
+  }
+}
+
+/* Start a background resync; the current model is served until it lands */
+static int model_resync(void) { return fetch_start(); }
+
+/* --- Event Stream (socket2) --- */
+static int events_connect(void) {
+  if (event_fd >= 0)
+    return 0;
+
+  event_fd = connect_socket(SOCKET_EVENTS, true);
+  if (event_fd < 0)
+    return -1;
+
+  event_len = 0;
+  return 0;
+}
+
+static void events_disconnect(void) {
+  if (event_fd >= 0) {
+    close(event_fd);
+    event_fd = -1;
+  }
+  event_len = 0;
+  model_synced = false;
+}
+
+/*
+ * An event left the model missing something only j/clients reports: start
+ * a fresh fetch now. One already in flight may have been answered before
+ * the event, so it is replaced.
+ */
+static void model_refetch(void) {
+  model_synced = false;
+  fetch_abort("superseded by an event");
+  model_resync();
+}
+
+/* Split off the next comma-separated field, advancing *data past it */
+static const char *next_field(char **data) {
+  char *start = *data;
+  char *comma = strchr(start, ',');
+  if (comma) {
+    *comma = '\0';
+    *data = comma + 1;
+  } else {
+    *data = start + strlen(start);
+  }
+  return start;
+}
+
+static void handle_event(const char *name, char *data) {
+  char address[32];
+
+  if (strcmp(name, "openwindow") == 0) {
+    /* openwindow>>ADDRESS,WORKSPACENAME,CLASS,TITLE */
+    const char *addr = next_field(&data);
+    const char *ws = next_field(&data);
+    const char *cls = next_field(&data);
+    const char *title = data;
+
+    format_address(address, sizeof(address), addr, strlen(addr));
+    int wid;
+    if (!workspace_from_name(ws, &wid)) {
+      /* Named workspace: its id is only available from j/clients */
+      model_refetch();
+      return;
+    }
+
+    int idx = model_find(address);
+    if (idx >= 0)
+      model_remove(idx);
+
+    WindowInfo info;
+    info.address = heap_strdup(address);
+    info.title = heap_strdup(title);
+    info.class_name = heap_strdup(cls);
+    info.class_atom = atom_intern(cls);
+    info.workspace_id = wid;
+    info.focus_history_id = 0;
+    info.is_active = false;
+    info.is_floating = false;
+    info.group_count = 1;
+    info.first_member = 0;
+    if (app_state_add(&model, &info) < 0)
+      window_info_free(&info);
+    model_generation++;
+
+    /*
+     * The event does not say whether the window opened floating, and a
+     * window rule that floats it sends no changefloatingmode. List it
+     * tiled until the refetch brings its real state.
+     */
+    model_refetch();
+  } else if (strcmp(name, "closewindow") == 0) {
+    format_address(address, sizeof(address), data, strlen(data));
+    int idx = model_find(address);
+    if (idx >= 0) {
+      model_remove(idx);
+      model_generation++;
+    }
+    capture_forget(address);
+  } else if (strcmp(name, "activewindowv2") == 0) {
+    /* Empty (or ",") when focus moves to no window */
+    size_t len = strcspn(data, ",");
+    if (len == 0) {
+      model_set_active("");
     } else {
-      int found = -1;
-      for (int j = 0; j < out_count; j++) {
-        if (!out[j].is_floating && out[j].workspace_id == win->workspace_id &&
-            strcmp(out[j].class_name, win->class_name) == 0) {
-          found = j;
-          break;
-        }
+      format_address(address, sizeof(address), data, len);
+      model_set_active(address);
+    }
+    model_generation++;
+  } else if (strcmp(name, "windowtitlev2") == 0) {
+    /* windowtitlev2>>ADDRESS,TITLE */
+    saw_title_v2 = true;
+    const char *addr = next_field(&data);
+    format_address(address, sizeof(address), addr, strlen(addr));
+    int idx = model_find(address);
+    if (idx >= 0) {
+      char *title = heap_strdup(data);
+      if (title) {
+        free(model.windows[idx].title);
+        model.windows[idx].title = title;
+        model_generation++;
       }
+    }
+  } else if (strcmp(name, "windowtitle") == 0) {
+    /* Older Hyprland only reports the address; refetch on next show */
+    if (!saw_title_v2)
+      model_synced = false;
+  } else if (strcmp(name, "movewindowv2") == 0) {
+    /* movewindowv2>>ADDRESS,WORKSPACEID,WORKSPACENAME */
+    saw_move_v2 = true;
+    const char *addr = next_field(&data);
+    const char *wid = next_field(&data);
+    format_address(address, sizeof(address), addr, strlen(addr));
+    int idx = model_find(address);
+    if (idx >= 0) {
+      model.windows[idx].workspace_id = atoi(wid);
+      model_generation++;
+    }
+  } else if (strcmp(name, "movewindow") == 0) {
+    /* movewindow>>ADDRESS,WORKSPACENAME */
+    if (saw_move_v2)
+      return;
+    const char *addr = next_field(&data);
+    format_address(address, sizeof(address), addr, strlen(addr));
+    int idx = model_find(address);
+    int wid;
+    if (idx < 0)
+      return;
+    if (workspace_from_name(data, &wid)) {
+      model.windows[idx].workspace_id = wid;
+      model_generation++;
+    } else
+      model_synced = false;
+  } else if (strcmp(name, "changefloatingmode") == 0) {
+    /* changefloatingmode>>ADDRESS,FLOATING */
+    const char *addr = next_field(&data);
+    format_address(address, sizeof(address), addr, strlen(addr));
+    int idx = model_find(address);
+    if (idx >= 0) {
+      model.windows[idx].is_floating = (atoi(data) != 0);
+      model_generation++;
+    }
+  }
+}
+
+int hyprland_get_poll_fds(struct pollfd *fds, int max) {
+  int n = 0;
+  if (event_fd >= 0 && n < max) {
+    fds[n].fd = event_fd;
+    fds[n].events = POLLIN;
+    n++;
+  }
+  if (fetch.phase != FETCH_IDLE && n < max) {
+    fds[n].fd = fetch.fd;
+    fds[n].events = fetch.phase == FETCH_WRITING ? POLLOUT : POLLIN;
+    n++;
+  }
+  for (int i = 0; i < pending_count && n < max; i++) {
+    fds[n].fd = pending_replies[i].fd;
+    fds[n].events = POLLIN;
+    n++;
+  }
+  return n;
+}
+
+int hyprland_get_timeout(void) {
+  if (fetch.phase == FETCH_IDLE)
+    return -1;
+  long long left = fetch.deadline - now_ms();
+  return left > 0 ? (int)left : 0;
+}
+
+/* Read whatever the event stream has buffered */
+static void read_events(void) {
+  if (event_fd < 0)
+    return;
+
+  while (1) {
+    ssize_t n = read(event_fd, event_buf + event_len,
+                     sizeof(event_buf) - event_len - 1);
+    if (n < 0) {
+      if (errno == EINTR)
+        continue;
+      if (errno == EAGAIN || errno == EWOULDBLOCK)
+        break;
+      LOG("Event stream error: %s", strerror(errno));
+      events_disconnect();
+      return;
+    }
+    if (n == 0) {
+      LOG("Event stream closed, will resync on next show");
+      events_disconnect();
+      return;
+    }
 
-      if (found >= 0) {
-        out[found].group_count++;
-      } else {
-        out[out_count].address = safe_strdup(win->address);
-        out[out_count].title = safe_strdup(win->title);
-        out[out_count].class_name = safe_strdup(win->class_name);
-        out[out_count].workspace_id = win->workspace_id;
-        out[out_count].focus_history_id = win->focus_history_id;
-        out[out_count].is_active = win->is_active;
-        out[out_count].is_floating = false;
-        out[out_count].group_count = 1;
-        out_count++;
+    event_len += n;
+    event_buf[event_len] = '\0';
+
+    /* Process every complete line: EVENT>>DATA\n */
+    char *line = event_buf;
+    char *nl;
+    while ((nl = strchr(line, '\n')) != NULL) {
+      *nl = '\0';
+      char *sep = strstr(line, ">>");
+      if (sep) {
+        *sep = '\0';
+        handle_event(line, sep + 2);
       }
+      line = nl + 1;
+    }
+
+    size_t rest = event_len - (line - event_buf);
+    if (rest == sizeof(event_buf) - 1) {
+      /* Oversized line: drop it and refetch rather than misparse */
+      LOG("Event line too long, dropping");
+      rest = 0;
+      model_synced = false;
     }
+    memmove(event_buf, line, rest);
+    event_len = rest;
   }
+}
 
-  for (int i = 0; i < count; i++)
-    window_info_free(&state->windows[i]);
-  free(state->windows);
+bool hyprland_dispatch_events(void) {
+  drain_replies();
 
-  state->windows = out;
-  state->count = out_count;
-  state->capacity = count;
+  bool refreshed = fetch_step() > 0;
+  fetch_check_deadline();
+
+  read_events();
+  return refreshed;
 }
 
 /* --- Public API --- */
@@ -279,18 +950,36 @@ int update_window_list(AppState *state, Config *cfg) {
   if (!state)
     return -1;
 
-  char *json = hyprland_request("j/clients");
-  if (!json)
-    return -1;
+  /* Serve the last known list now; a fresh one is reconciled on arrival */
+  if (!model_synced) {
+    events_connect();
+    model_resync();
+  }
 
-  if (parse_clients(json, state) < 0) {
-    free(json);
+  if (app_state_reserve(state, model.count) < 0)
     return -1;
-  }
-  free(json);
 
-  if (state->count > 1) {
-    qsort(state->windows, state->count, sizeof(WindowInfo), compare_mru);
+  /* Snapshot the model; special workspaces (id < 0) are not listed */
+  int mru = 0;
+  for (int i = 0; i < model.count; i++) {
+    WindowInfo *src = &model.windows[i];
+    if (src->workspace_id < 0)
+      continue;
+
+    WindowInfo *dst = &state->windows[state->count];
+    *dst = *src;
+    dst->address = app_state_strdup(state, src->address);
+    dst->title = app_state_strdup(state, src->title);
+    dst->class_name = app_state_strdup(state, src->class_name);
+    dst->focus_history_id = mru++;
+    dst->group_count = 1;
+    dst->first_member = state->count;
+    if (!dst->address || !dst->title || !dst->class_name) {
+      if (!state->arena_backed)
+        window_info_free(dst);
+      return -1;
+    }
+    state->count++;
   }
 
   if (cfg && cfg->mode == MODE_CONTEXT) {
@@ -300,12 +989,49 @@ int update_window_list(AppState *state, Config *cfg) {
   return 0;
 }
 
+void hyprland_request_previews(void) {
+  if (!capture_available())
+    return;
+  int queued = 0;
+  for (int i = 0; i < model.count && queued < PREVIEW_SEED_COUNT; i++) {
+    if (model.windows[i].workspace_id < 0)
+      continue;
+    capture_request(model.windows[i].address);
+    queued++;
+  }
+}
+
+uint64_t hyprland_get_generation(void) {
+  /* A stale model is refetched on show, so it can never be reused */
+  return model_synced ? model_generation : 0;
+}
+
+int hyprland_fetch_sync(void) {
+  if (model_resync() < 0)
+    return -1;
+  return fetch_wait();
+}
+
+void hyprland_flush_replies(int timeout_ms) {
+  long long deadline = now_ms() + timeout_ms;
+  while (pending_count > 0 && now_ms() < deadline) {
+    struct pollfd fds[MAX_PENDING_REPLIES];
+    for (int i = 0; i < pending_count; i++) {
+      fds[i].fd = pending_replies[i].fd;
+      fds[i].events = POLLIN;
+    }
+    poll(fds, pending_count, 10);
+    drain_replies();
+  }
+}
+
 void switch_to_window(const char *address) {
   if (!address)
     return;
   char cmd[256];
   snprintf(cmd, sizeof(cmd), "dispatch focuswindow address:%s", address);
-  char *resp = hyprland_request(cmd);
-  if (resp)
-    free(resp);
+
+  /* Don't block the panel on Hyprland's reply */
+  const char *cmds[] = {cmd};
+  hyprland_command(cmds, 1, false);
 }
@@ -4,6 +4,7 @@
 
 #include "config.h"
 #include "data.h"
+#include <poll.h>
 
 /* Initialize AppState */
 void app_state_init(AppState *state);
@@ -13,14 +14,52 @@ void app_state_free(AppState *state);
 
 /*
  * Update window list from Hyprland.
- * Populates state with windows, sorted by MRU.
+ * Populates state from the event-driven window model, sorted by MRU.
+ * When the model is stale (event stream down) the last known list is
+ * returned at once and a background j/clients fetch is started; its
+ * arrival is reported by hyprland_dispatch_events().
  * Handles aggregation if Mode == CONTEXT.
  */
 int update_window_list(AppState *state, Config *config);
 
-/* Switch focus to window address */
+/*
+ * Send commands over one connection ([[BATCH]] when count > 1).
+ * wait == false: returns NULL at once, the reply is drained from the event
+ * loop. wait == true: blocks (bounded by a timeout) and returns the reply
+ * (caller frees).
+ */
+char *hyprland_command(const char *const *cmds, int count, bool wait);
+
+/* Queue preview captures for the most recently used windows */
+void hyprland_request_previews(void);
+
+/* Switch focus to window address (non-blocking, reply drained later) */
 void switch_to_window(const char *address);
 
+/* Generation of the event-driven window model, 0 while it is not synced */
+uint64_t hyprland_get_generation(void);
+
+/*
+ * Fetch j/clients and replace the model, blocking for at most the IPC
+ * timeout (for benchmarks; the daemon fetches from its poll loop).
+ */
+int hyprland_fetch_sync(void);
+
+/* Block until every fire-and-forget reply is drained or timeout_ms passes */
+void hyprland_flush_replies(int timeout_ms);
+
+/* Fill fds with the event stream, an in-flight fetch and command replies */
+int hyprland_get_poll_fds(struct pollfd *fds, int max);
+
+/* Milliseconds until the in-flight fetch times out (-1 if none) */
+int hyprland_get_timeout(void);
+
+/*
+ * Drain pending socket2 events and command replies, and advance the fetch.
+ * Returns true when a fresh window list has just been adopted.
+ */
+bool hyprland_dispatch_events(void);
+
 int hyprland_backend_init(void);
 void hyprland_backend_cleanup(void);
 const char *hyprland_get_name(void);
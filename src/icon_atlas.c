@@ -0,0 +1,129 @@
+/* src/icon_atlas.c - App icons baked into one shared surface */
+#include "icon_atlas.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#define LOG(fmt, ...) fprintf(stderr, "[IconAtlas] " fmt "\n", ##__VA_ARGS__)
+
+typedef struct {
+  Atom class_atom;
+  uint64_t stamp; /* Last insert or lookup, 0 = empty */
+  bool blank;     /* cls has no icon; the pixels are unused */
+} Cell;
+
+static cairo_surface_t *atlas = NULL;
+static int cell_size = 0;
+static Cell cells[ICON_ATLAS_CELLS];
+static uint64_t tick = 0;
+
+static void cell_origin(int i, int *x, int *y) {
+  *x = (i % ICON_ATLAS_COLUMNS) * cell_size;
+  *y = (i / ICON_ATLAS_COLUMNS) * cell_size;
+}
+
+bool icon_atlas_reset(int size) {
+  memset(cells, 0, sizeof(cells));
+  tick = 0;
+  if (size <= 0) {
+    icon_atlas_cleanup();
+    return false;
+  }
+
+  if (atlas && size == cell_size) {
+    /* Same geometry: clear the pixels, keep the surface */
+    cairo_t *cr = cairo_create(atlas);
+    cairo_set_operator(cr, CAIRO_OPERATOR_CLEAR);
+    cairo_paint(cr);
+    cairo_destroy(cr);
+    return true;
+  }
+
+  icon_atlas_cleanup();
+  int rows = (ICON_ATLAS_CELLS + ICON_ATLAS_COLUMNS - 1) / ICON_ATLAS_COLUMNS;
+  atlas = cairo_image_surface_create(CAIRO_FORMAT_ARGB32,
+                                     ICON_ATLAS_COLUMNS * size, rows * size);
+  if (cairo_surface_status(atlas) != CAIRO_STATUS_SUCCESS) {
+    LOG("No memory for %dpx icons", size);
+    cairo_surface_destroy(atlas);
+    atlas = NULL;
+    return false;
+  }
+  cell_size = size;
+  return true;
+}
+
+bool icon_atlas_lookup(Atom cls, BlitImage *icon) {
+  if (!atlas)
+    return false;
+  for (int i = 0; i < ICON_ATLAS_CELLS; i++) {
+    if (!cells[i].stamp || cells[i].class_atom != cls)
+      continue;
+    cells[i].stamp = ++tick;
+    if (cells[i].blank) {
+      memset(icon, 0, sizeof(*icon));
+      return true;
+    }
+
+    int x, y;
+    cell_origin(i, &x, &y);
+    icon->stride = cairo_image_surface_get_stride(atlas);
+    icon->data = cairo_image_surface_get_data(atlas) +
+                 (size_t)y * icon->stride + (size_t)x * 4;
+    icon->width = cell_size;
+    icon->height = cell_size;
+    icon->x0 = 0;
+    icon->y0 = 0;
+    icon->x1 = cell_size;
+    icon->y1 = cell_size;
+    return true;
+  }
+  return false;
+}
+
+/* Give cls an empty cell, else the least recently used one */
+static int claim_cell(Atom cls, bool blank) {
+  int victim = 0;
+  for (int i = 0; i < ICON_ATLAS_CELLS && cells[victim].stamp; i++) {
+    if (cells[i].stamp < cells[victim].stamp)
+      victim = i;
+  }
+  cells[victim].class_atom = cls;
+  cells[victim].stamp = ++tick;
+  cells[victim].blank = blank;
+  return victim;
+}
+
+bool icon_atlas_insert(Atom cls, int *x, int *y) {
+  if (!atlas)
+    return false;
+  cell_origin(claim_cell(cls, false), x, y);
+
+  /* The evicted icon must not bleed into the new one */
+  cairo_surface_flush(atlas);
+  int stride = cairo_image_surface_get_stride(atlas);
+  unsigned char *data = cairo_image_surface_get_data(atlas);
+  for (int row = 0; row < cell_size; row++)
+    memset(data + (size_t)(*y + row) * stride + (size_t)*x * 4, 0,
+           (size_t)cell_size * 4);
+  cairo_surface_mark_dirty(atlas);
+  return true;
+}
+
+bool icon_atlas_insert_blank(Atom cls) {
+  if (!atlas)
+    return false;
+  claim_cell(cls, true);
+  return true;
+}
+
+cairo_surface_t *icon_atlas_surface(void) { return atlas; }
+
+void icon_atlas_cleanup(void) {
+  if (atlas)
+    cairo_surface_destroy(atlas);
+  atlas = NULL;
+  cell_size = 0;
+  memset(cells, 0, sizeof(cells));
+  tick = 0;
+}
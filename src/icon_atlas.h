@@ -0,0 +1,46 @@
+/* src/icon_atlas.h - App icons baked into one shared surface */
+#ifndef ICON_ATLAS_H
+#define ICON_ATLAS_H
+
+#include "atoms.h"
+#include "blit.h"
+#include <cairo/cairo.h>
+#include <stdbool.h>
+
+/*
+ * Every class's icon (or letter fallback) is drawn once, already masked
+ * to its rounded corners, into a square cell of a single ARGB32 surface.
+ * Drawing an icon is then a rectangle blit from its cell. One batch of
+ * cards never touches more classes than there are cells, so the least
+ * recently used cell evicted by a bake is never one the batch still uses.
+ * Daemon thread only; cell pixels may be read from any thread until the
+ * next bake or reset.
+ */
+#define ICON_ATLAS_COLUMNS 8
+#define ICON_ATLAS_CELLS 64
+
+/* Drop every icon and size the cells for size x size icons */
+bool icon_atlas_reset(int size);
+
+/*
+ * cls's baked icon as a cell-sized image; false if it has none yet. A
+ * blank cell is found with icon->data NULL.
+ */
+bool icon_atlas_lookup(Atom cls, BlitImage *icon);
+
+/*
+ * Claim a cleared cell for cls, evicting the least recently used one, and
+ * return its origin in icon_atlas_surface() for the caller to draw into.
+ */
+bool icon_atlas_insert(Atom cls, int *x, int *y);
+
+/* Record that cls has nothing to draw, so it is not looked up again */
+bool icon_atlas_insert_blank(Atom cls);
+
+/* The atlas surface, NULL before icon_atlas_reset() */
+cairo_surface_t *icon_atlas_surface(void);
+
+/* Free the atlas */
+void icon_atlas_cleanup(void);
+
+#endif /* ICON_ATLAS_H */
@@ -83,13 +83,19 @@ static const ClassMapping class_mappings[] = {
     {NULL, NULL} /* Sentinel */
 };
 
+#define NUM_MAPPINGS (sizeof(class_mappings) / sizeof(class_mappings[0]) - 1)
+
+/* Each wm_class lowercased and interned, so matching a class is an integer
+ * compare (filled by icons_init()) */
+static Atom mapping_atoms[NUM_MAPPINGS];
+
 /* =========================================================================
  * INTERNAL TYPES
  * ========================================================================= */
 
-/* Icon cache entry */
+/* Icon cache entry, keyed by the original (unmapped) class atom */
 typedef struct {
-  char class_name[128];
+  Atom class_atom;
   int size;
   cairo_surface_t *surface;
 } IconCacheEntry;
@@ -131,16 +137,25 @@ static int file_exists(const char *path) {
   return stat(path, &st) == 0 && S_ISREG(st.st_mode);
 }
 
-/* Lookup mapped class name, returns NULL if no mapping exists */
-static const char *get_mapped_class(const char *class_name) {
-  for (int i = 0; class_mappings[i].wm_class != NULL; i++) {
-    if (strcasecmp(class_mappings[i].wm_class, class_name) == 0) {
+/* Lookup mapped class name (case-insensitive), NULL if no mapping exists */
+static const char *get_mapped_class(Atom class_atom) {
+  Atom lower = atom_intern(atom_lower(class_atom));
+  for (size_t i = 0; i < NUM_MAPPINGS; i++) {
+    if (mapping_atoms[i] == lower) {
       return class_mappings[i].icon_name;
     }
   }
   return NULL;
 }
 
+static void intern_mappings(void) {
+  char lowercase[128];
+  for (size_t i = 0; i < NUM_MAPPINGS; i++) {
+    to_lowercase(lowercase, class_mappings[i].wm_class, sizeof(lowercase));
+    mapping_atoms[i] = atom_intern(lowercase);
+  }
+}
+
 /* =========================================================================
  * PATH INITIALIZATION
  * ========================================================================= */
@@ -511,6 +526,7 @@ static cairo_surface_t *load_svg_icon(const char *path, int size) {
 /* Initialize icon system */
 void icons_init(const char *theme_name, const char *fallback) {
   init_paths();
+  intern_mappings();
 
   if (theme_name && theme_name[0]) {
     strncpy(current_theme, theme_name, sizeof(current_theme) - 1);
@@ -526,22 +542,13 @@ void icons_init(const char *theme_name, const char *fallback) {
 }
 
 /* Load app icon by class name */
-cairo_surface_t *load_app_icon(const char *class_name, int size) {
-  if (!class_name || !class_name[0])
+cairo_surface_t *load_app_icon(Atom class_atom, int size) {
+  if (class_atom == ATOM_NONE)
     return NULL;
 
-  /* Apply class name mapping first */
-  const char *effective_class = get_mapped_class(class_name);
-  if (effective_class) {
-    LOG("Mapped class '%s' -> '%s'", class_name, effective_class);
-  } else {
-    effective_class = class_name;
-  }
-
-  /* Check cache using ORIGINAL class name (for consistency) */
+  /* Check cache first: atom and size compares only */
   for (int i = 0; i < cache_count; i++) {
-    if (strcmp(icon_cache[i].class_name, class_name) == 0 &&
-        icon_cache[i].size == size) {
+    if (icon_cache[i].class_atom == class_atom && icon_cache[i].size == size) {
       if (icon_cache[i].surface) {
         cairo_surface_reference(icon_cache[i].surface);
       }
@@ -549,6 +556,15 @@ cairo_surface_t *load_app_icon(const char *class_name, int size) {
     }
   }
 
+  /* Cache miss: apply class name mapping */
+  const char *class_name = atom_name(class_atom);
+  const char *effective_class = get_mapped_class(class_atom);
+  if (effective_class) {
+    LOG("Mapped class '%s' -> '%s'", class_name, effective_class);
+  } else {
+    effective_class = class_name;
+  }
+
   /* Find icon name from desktop file using effective (mapped) class */
   char *icon_name = find_desktop_icon(effective_class);
   LOG("Class '%s' -> icon '%s'", effective_class,
@@ -557,7 +573,7 @@ cairo_surface_t *load_app_icon(const char *class_name, int size) {
   if (!icon_name) {
     /* Cache NULL result */
     if (cache_count < MAX_CACHE) {
-      strncpy(icon_cache[cache_count].class_name, class_name, 127);
+      icon_cache[cache_count].class_atom = class_atom;
       icon_cache[cache_count].size = size;
       icon_cache[cache_count].surface = NULL;
       cache_count++;
@@ -584,7 +600,7 @@ cairo_surface_t *load_app_icon(const char *class_name, int size) {
     if (surface) {
       /* Cache result */
       if (cache_count < MAX_CACHE) {
-        strncpy(icon_cache[cache_count].class_name, class_name, 127);
+        icon_cache[cache_count].class_atom = class_atom;
         icon_cache[cache_count].size = size;
         icon_cache[cache_count].surface = surface;
         cairo_surface_reference(surface);
@@ -652,10 +668,9 @@ cairo_surface_t *load_app_icon(const char *class_name, int size) {
     }
   }
 
-  /* Cache result (including original class_name for cache lookup consistency)
-   */
+  /* Cache result under the original class atom */
   if (cache_count < MAX_CACHE) {
-    strncpy(icon_cache[cache_count].class_name, class_name, 127);
+    icon_cache[cache_count].class_atom = class_atom;
     icon_cache[cache_count].size = size;
     icon_cache[cache_count].surface = surface;
     if (surface) {
@@ -668,17 +683,17 @@ cairo_surface_t *load_app_icon(const char *class_name, int size) {
 }
 
 /* Check if icon exists for app */
-bool has_app_icon(const char *class_name) {
-  if (!class_name)
+bool has_app_icon(Atom class_atom) {
+  if (class_atom == ATOM_NONE)
     return false;
 
   for (int i = 0; i < cache_count; i++) {
-    if (strcmp(icon_cache[i].class_name, class_name) == 0) {
+    if (icon_cache[i].class_atom == class_atom) {
       return icon_cache[i].surface != NULL;
     }
   }
 
-  cairo_surface_t *s = load_app_icon(class_name, 48);
+  cairo_surface_t *s = load_app_icon(class_atom, 48);
   if (s) {
     cairo_surface_destroy(s);
     return true;
@@ -2,19 +2,20 @@
 #ifndef ICONS_H
 #define ICONS_H
 
+#include "atoms.h"
 #include <cairo/cairo.h>
 #include <stdbool.h>
 
 /* Initialize icon cache and theme lookup */
 void icons_init(const char *theme_name, const char *fallback_theme);
 
-/* Load an app icon by class name (returns NULL if not found) */
-cairo_surface_t *load_app_icon(const char *class_name, int size);
+/* Load an app icon by interned class name (returns NULL if not found) */
+cairo_surface_t *load_app_icon(Atom class_atom, int size);
 
 /* Free all cached icons */
 void icons_cleanup(void);
 
 /* Check if icon exists for app */
-bool has_app_icon(const char *class_name);
+bool has_app_icon(Atom class_atom);
 
 #endif /* ICONS_H */
@@ -116,7 +116,7 @@ static void keyboard_key(void *data, struct wl_keyboard *keyboard,
         if (app_state->selected_index >= app_state->count)
           app_state->selected_index = 0;
       }
-      render_ui(app_state, app_state->width, app_state->height);
+      render_schedule(app_state);
     }
     break;
 
@@ -0,0 +1,150 @@
+/* src/ipc_trace.c - Record Hyprland IPC exchanges for offline replay */
+#define _POSIX_C_SOURCE 200809L
+
+#include "ipc_trace.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define LOG(fmt, ...) fprintf(stderr, "[Trace] " fmt "\n", ##__VA_ARGS__)
+
+static FILE *trace_file = NULL;
+static long long trace_origin = -1;
+
+long long ipc_trace_now_us(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (long long)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+void ipc_trace_init(void) {
+  const char *path = getenv("SNAPPY_IPC_TRACE");
+  if (!path || !path[0] || trace_file)
+    return;
+
+  trace_file = fopen(path, "w");
+  if (!trace_file) {
+    LOG("Cannot open %s for writing", path);
+    return;
+  }
+  fputs(IPC_TRACE_HEADER, trace_file);
+  trace_origin = -1;
+  LOG("Recording Hyprland IPC to %s", path);
+}
+
+bool ipc_trace_enabled(void) { return trace_file != NULL; }
+
+void ipc_trace_record(long long start_us, const char *request,
+                      size_t request_len, const char *response,
+                      size_t response_len) {
+  if (!trace_file)
+    return;
+
+  if (trace_origin < 0)
+    trace_origin = start_us;
+
+  IpcTraceEntry entry = {
+      .start_us = start_us - trace_origin,
+      .duration_us = ipc_trace_now_us() - start_us,
+      .request = (char *)request,
+      .request_len = request_len,
+      .response = (char *)(response ? response : ""),
+      .response_len = response ? response_len : 0,
+  };
+  ipc_trace_write(trace_file, &entry);
+
+  /* Keep the trace usable if the daemon dies mid-session */
+  fflush(trace_file);
+}
+
+void ipc_trace_close(void) {
+  if (trace_file) {
+    fclose(trace_file);
+    trace_file = NULL;
+  }
+}
+
+int trace_buf_append(TraceBuf *buf, const char *data, size_t len) {
+  if (buf->len + len > buf->cap) {
+    size_t cap = buf->cap ? buf->cap : 4096;
+    while (cap < buf->len + len)
+      cap *= 2;
+    char *tmp = realloc(buf->data, cap);
+    if (!tmp)
+      return -1;
+    buf->data = tmp;
+    buf->cap = cap;
+  }
+  memcpy(buf->data + buf->len, data, len);
+  buf->len += len;
+  return 0;
+}
+
+void trace_buf_free(TraceBuf *buf) {
+  free(buf->data);
+  buf->data = NULL;
+  buf->len = buf->cap = 0;
+}
+
+int ipc_trace_write(FILE *f, const IpcTraceEntry *entry) {
+  if (fprintf(f, "@ %lld %lld %zu %zu\n", entry->start_us, entry->duration_us,
+              entry->request_len, entry->response_len) < 0)
+    return -1;
+  if (fwrite(entry->request, 1, entry->request_len, f) != entry->request_len ||
+      fputc('\n', f) == EOF)
+    return -1;
+  if (fwrite(entry->response, 1, entry->response_len, f) !=
+          entry->response_len ||
+      fputc('\n', f) == EOF)
+    return -1;
+  return 0;
+}
+
+/* Read len payload bytes plus the trailing newline */
+static char *read_payload(FILE *f, size_t len) {
+  char *data = malloc(len + 1);
+  if (!data)
+    return NULL;
+  if (fread(data, 1, len, f) != len || fgetc(f) != '\n') {
+    free(data);
+    return NULL;
+  }
+  data[len] = '\0';
+  return data;
+}
+
+int ipc_trace_read(FILE *f, IpcTraceEntry *entry) {
+  char line[256];
+  memset(entry, 0, sizeof(*entry));
+
+  /* Skip comments and blank lines up to the next entry header */
+  while (1) {
+    if (!fgets(line, sizeof(line), f))
+      return 0;
+    if (line[0] == '@')
+      break;
+    if (line[0] != '#' && line[0] != '\n')
+      return -1;
+  }
+
+  if (sscanf(line, "@ %lld %lld %zu %zu", &entry->start_us,
+             &entry->duration_us, &entry->request_len,
+             &entry->response_len) != 4)
+    return -1;
+
+  entry->request = read_payload(f, entry->request_len);
+  entry->response = entry->request ? read_payload(f, entry->response_len)
+                                   : NULL;
+  if (!entry->request || !entry->response) {
+    ipc_trace_entry_free(entry);
+    return -1;
+  }
+  return 1;
+}
+
+void ipc_trace_entry_free(IpcTraceEntry *entry) {
+  free(entry->request);
+  free(entry->response);
+  entry->request = NULL;
+  entry->response = NULL;
+}
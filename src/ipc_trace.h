@@ -0,0 +1,65 @@
+/* src/ipc_trace.h - Record Hyprland IPC exchanges for offline replay */
+#ifndef IPC_TRACE_H
+#define IPC_TRACE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+/*
+ * Trace file format (text header, raw payloads):
+ *
+ *   # snappy-switcher ipc trace v1
+ *   @ <start_us> <duration_us> <request_len> <response_len>
+ *   <request bytes>\n
+ *   <response bytes>\n
+ *
+ * start_us is relative to the first recorded exchange; duration_us runs
+ * from connect to the end of the reply.
+ */
+#define IPC_TRACE_HEADER "# snappy-switcher ipc trace v1\n"
+
+/* Growable byte buffer for payloads being recorded */
+typedef struct {
+  char *data;
+  size_t len;
+  size_t cap;
+} TraceBuf;
+
+typedef struct {
+  long long start_us;
+  long long duration_us;
+  char *request;
+  size_t request_len;
+  char *response;
+  size_t response_len;
+} IpcTraceEntry;
+
+/* Start recording to $SNAPPY_IPC_TRACE if it is set */
+void ipc_trace_init(void);
+
+/* True while a trace file is open */
+bool ipc_trace_enabled(void);
+
+/* CLOCK_MONOTONIC in microseconds */
+long long ipc_trace_now_us(void);
+
+/* Append one exchange that started at start_us and ended now */
+void ipc_trace_record(long long start_us, const char *request,
+                      size_t request_len, const char *response,
+                      size_t response_len);
+
+void ipc_trace_close(void);
+
+int trace_buf_append(TraceBuf *buf, const char *data, size_t len);
+void trace_buf_free(TraceBuf *buf);
+
+/* Write one entry (used by recorders and trace generators) */
+int ipc_trace_write(FILE *f, const IpcTraceEntry *entry);
+
+/* Read the next entry: 1 = entry read, 0 = end of file, -1 = bad trace */
+int ipc_trace_read(FILE *f, IpcTraceEntry *entry);
+
+void ipc_trace_entry_free(IpcTraceEntry *entry);
+
+#endif /* IPC_TRACE_H */
@@ -1,12 +1,19 @@
 /* src/main.c - Snappy Switcher Daemon (v2.0) */
 #define _POSIX_C_SOURCE 200809L
 
+#include "atoms.h"
 #include "backend.h"
+#include "blit.h"
+#include "capture.h"
 #include "config.h"
 #include "icons.h"
 #include "input.h"
 #include "render.h"
+#include "shm_pool.h"
 #include "socket.h"
+#include "text.h"
+#include "workers.h"
+#include "hyprland-toplevel-export-v1-client-protocol.h"
 #include "wlr-layer-shell-unstable-v1-client-protocol.h"
 #include "xdg-shell-client-protocol.h"
 
@@ -54,8 +61,23 @@ static int socket_fd = -1;
 
 static Backend *backend = NULL;
 
-/* Startup Race Condition Fix */
-// static bool first_show_done = false;
+/* Prefetch cache: snapshot + pre-rendered frame waiting for the next show */
+static bool prefetch_valid = false;
+static struct timespec prefetch_time;
+static unsigned long prefetch_hits = 0;
+static unsigned long prefetch_misses = 0;
+
+/*
+ * Snapshot reuse: the backend generation the current snapshot was built
+ * from (0 = not reusable), and the generation the first frame of the last
+ * show was rendered for. An unchanged window list is shown again without
+ * rebuilding the snapshot or rendering.
+ */
+static uint64_t snapshot_generation = 0;
+static uint64_t kept_generation = 0;
+static bool first_frame_pending = false;
+static unsigned long snapshot_reuses = 0;
+static size_t snapshot_heap_allocs = 0; /* Made by the last rebuild */
 
 /* Signal Handling */
 static volatile sig_atomic_t should_quit = 0;
@@ -71,6 +93,19 @@ static void sleep_ms(int ms) {
   nanosleep(&ts, NULL);
 }
 
+/* The kept first frame still matches the snapshot and previews */
+static bool kept_frame_current(void) {
+  return snapshot_generation != 0 && kept_generation == snapshot_generation &&
+         render_kept_shows(&app_state, app_state.width, app_state.height);
+}
+
+static long elapsed_ms(const struct timespec *since) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (now.tv_sec - since->tv_sec) * 1000 +
+         (now.tv_nsec - since->tv_nsec) / 1000000;
+}
+
 /* --- Wayland Events --- */
 static void layer_surface_configure(void *data,
                                     struct zwlr_layer_surface_v1 *layer_surf,
@@ -81,10 +116,25 @@ static void layer_surface_configure(void *data,
     app_state.height = h;
   }
   zwlr_layer_surface_v1_ack_configure(layer_surf, serial);
+  if (!visible)
+    return;
 
-  if (visible) {
-    render_ui(&app_state, app_state.width, app_state.height);
+  /* The first frame of a show is kept for the next show */
+  bool first = first_frame_pending;
+  first_frame_pending = false;
+  if (first && kept_frame_current() &&
+      render_present_kept(&app_state, app_state.width, app_state.height)) {
+    LOG("Reused frame of unchanged snapshot");
+    return;
   }
+
+  /* A prefetched frame only needs to be attached */
+  if (!render_present(app_state.width, app_state.height, first) &&
+      render_prepare(&app_state, app_state.width, app_state.height))
+    render_present(app_state.width, app_state.height, first);
+
+  if (first)
+    kept_generation = snapshot_generation;
 }
 
 static void layer_surface_closed(void *data,
@@ -125,7 +175,6 @@ static const struct wl_seat_listener seat_listener = {
 static void registry_global(void *data, struct wl_registry *registry,
                             uint32_t name, const char *interface,
                             uint32_t version) {
-  (void)version;
   AppState *state = (AppState *)data;
 
   if (strcmp(interface, wl_compositor_interface.name) == 0)
@@ -138,14 +187,21 @@ static void registry_global(void *data, struct wl_registry *registry,
   else if (strcmp(interface, wl_seat_interface.name) == 0) {
     seat = wl_registry_bind(registry, name, &wl_seat_interface, 4);
     wl_seat_add_listener(seat, &seat_listener, state);
-  }
+  } else if (strcmp(interface,
+                    hyprland_toplevel_export_manager_v1_interface.name) == 0 &&
+             config && config->show_previews)
+    capture_init(wl_registry_bind(
+        registry, name, &hyprland_toplevel_export_manager_v1_interface, 1));
+  else if (backend && backend->bind_global)
+    backend->bind_global(registry, name, interface, version);
 }
 
 static void registry_global_remove(void *data, struct wl_registry *registry,
                                    uint32_t name) {
   (void)data;
   (void)registry;
-  (void)name;
+  if (backend && backend->remove_global)
+    backend->remove_global(name);
 }
 
 static const struct wl_registry_listener registry_listener = {
@@ -205,6 +261,7 @@ static void hide_switcher(void) {
     return;
 
   visible = false;
+  render_cancel_frame();
 
   if (config && config->follow_monitor) {
     destroy_panel();
@@ -216,6 +273,66 @@ static void hide_switcher(void) {
   }
 }
 
+/* Fetch the window list and lay it out for the initial selection */
+static bool build_snapshot(void) {
+  if (!backend) {
+    LOG("Error: Backend not initialized");
+    return false;
+  }
+
+  /* Nothing changed since the last snapshot: keep it and its layout */
+  uint64_t generation = backend->get_generation ? backend->get_generation() : 0;
+  if (generation != 0 && generation == snapshot_generation) {
+    snapshot_reuses++;
+    LOG("Snapshot unchanged (generation %llu), reusing %d windows",
+        (unsigned long long)generation, app_state.count);
+    app_state.selected_index = (app_state.count > 1) ? 1 : 0;
+    app_state.first_row = 0;
+    return true;
+  }
+
+  size_t allocs_before = heap_allocations();
+  app_state_begin_snapshot(&app_state);
+  render_invalidate();
+  snapshot_generation = 0;
+
+  if (backend->get_windows(&app_state, config) < 0) {
+    LOG("Failed to update window list");
+    return false;
+  }
+  snapshot_generation =
+      backend->get_generation ? backend->get_generation() : 0;
+
+  app_state.selected_index = (app_state.count > 1) ? 1 : 0;
+  calculate_dimensions(&app_state, &app_state.width, &app_state.height);
+
+  /* Zero once the arenas have grown to fit the window list */
+  snapshot_heap_allocs = heap_allocations() - allocs_before;
+  LOG("Snapshot: %d windows, %zu heap allocations", app_state.count,
+      snapshot_heap_allocs);
+  return true;
+}
+
+/* Warm the snapshot, icons and first frame without mapping the surface */
+static void prefetch_switcher(void) {
+  if (visible)
+    return;
+
+  prefetch_valid = false;
+  render_discard();
+  if (!build_snapshot())
+    return;
+
+  /* The next show reuses the kept frame; nothing to render ahead */
+  if (kept_frame_current())
+    return;
+
+  if (render_prepare(&app_state, app_state.width, app_state.height)) {
+    clock_gettime(CLOCK_MONOTONIC, &prefetch_time);
+    prefetch_valid = true;
+  }
+}
+
 static void show_switcher(void) {
   LOG("Showing switcher...");
 
@@ -231,31 +348,79 @@ static void show_switcher(void) {
 
   input_reset_alt_state();
 
-  app_state_free(&app_state);
-  app_state_init(&app_state);
-
-  if (!backend) {
-    LOG("Error: Backend not initialized");
-    return;
-  }
-
-  if (backend->get_windows(&app_state, config) < 0) {
-    LOG("Failed to update window list");
-    return;
+  /* Events since the prefetch (window opened, closed, retitled, focused)
+   * make it stale however recent it is */
+  uint64_t generation = backend && backend->get_generation
+                            ? backend->get_generation()
+                            : 0;
+  bool hit = prefetch_valid && config &&
+             elapsed_ms(&prefetch_time) <= config->prefetch_ttl_ms &&
+             generation != 0 && generation == snapshot_generation;
+  prefetch_valid = false;
+
+  if (hit) {
+    prefetch_hits++;
+    LOG("Prefetch hit (hits: %lu, misses: %lu)", prefetch_hits,
+        prefetch_misses);
+  } else {
+    prefetch_misses++;
+    render_discard();
+    if (!build_snapshot())
+      return;
   }
 
-  app_state.selected_index = (app_state.count > 1) ? 1 : 0;
-
-  calculate_dimensions(&app_state, &app_state.width, &app_state.height);
   zwlr_layer_surface_v1_set_size(layer_surface, app_state.width,
                                  app_state.height);
   zwlr_layer_surface_v1_set_keyboard_interactivity(layer_surface, 1);
 
   visible = true;
+  first_frame_pending = true;
   wl_surface_commit(surface);
   wl_display_flush(display);
 }
 
+/*
+ * A fresh window list arrived after the snapshot was taken. Drop any
+ * prefetched frame; if the switcher is up, rebuild it in place and keep
+ * the selection on the same window when it still exists.
+ */
+static void reconcile_switcher(void) {
+  prefetch_valid = false;
+  render_discard();
+  if (!visible)
+    return;
+
+  /* The previous snapshot stays valid until the next one is started */
+  const char *selected =
+      app_state.count > 0 ? app_state.windows[app_state.selected_index].address
+                          : NULL;
+  uint32_t old_width = app_state.width;
+  uint32_t old_height = app_state.height;
+
+  if (!build_snapshot())
+    return;
+
+  for (int i = 0; selected && i < app_state.count; i++) {
+    if (strcmp(app_state.windows[i].address, selected) == 0) {
+      app_state.selected_index = i;
+      break;
+    }
+  }
+  LOG("Reconciled visible switcher: %d windows", app_state.count);
+
+  if (app_state.width != old_width || app_state.height != old_height) {
+    /* The configure handler renders at the new size */
+    zwlr_layer_surface_v1_set_size(layer_surface, app_state.width,
+                                   app_state.height);
+    wl_surface_commit(surface);
+  } else {
+    /* Paced like navigation; a frame in flight draws the new list */
+    render_invalidate();
+    render_schedule(&app_state);
+  }
+  wl_display_flush(display);
+}
+
 static void select_and_hide(void) {
   if (visible && app_state.count > 0 && backend) {
     WindowInfo *win = &app_state.windows[app_state.selected_index];
@@ -265,12 +430,30 @@ static void select_and_hide(void) {
   hide_switcher();
 }
 
-static void handle_command(const char *cmd) {
+static void handle_command(const char *cmd, int client) {
   if (strcmp(cmd, CMD_QUIT) == 0) {
     should_quit = 1;
     return;
   }
 
+  if (strcmp(cmd, CMD_PREFETCH) == 0) {
+    prefetch_switcher();
+    return;
+  }
+
+  if (strcmp(cmd, CMD_STATS) == 0) {
+    char reply[256];
+    int len = snprintf(reply, sizeof(reply),
+                       "prefetch_hits=%lu\nprefetch_misses=%lu\n"
+                       "snapshot_reuses=%lu\nsnapshot_heap_allocs=%zu\n"
+                       "heap_allocs=%zu\n",
+                       prefetch_hits, prefetch_misses, snapshot_reuses,
+                       snapshot_heap_allocs, heap_allocations());
+    if (write(client, reply, len) < 0)
+      LOG("Failed to send stats: %s", strerror(errno));
+    return;
+  }
+
   if (strcmp(cmd, CMD_HIDE) == 0) {
     hide_switcher();
     return;
@@ -297,7 +480,7 @@ static void handle_command(const char *cmd) {
     if (dir != 0 && app_state.count > 0) {
       app_state.selected_index =
           (app_state.selected_index + dir + app_state.count) % app_state.count;
-      render_ui(&app_state, app_state.width, app_state.height);
+      render_schedule(&app_state);
     } else if (strcmp(cmd, CMD_SELECT) == 0) {
       select_and_hide();
     }
@@ -319,6 +502,10 @@ static int run_client(const char *cmd) {
     socket_cmd = CMD_HIDE;
   else if (strcmp(cmd, "quit") == 0)
     socket_cmd = CMD_QUIT;
+  else if (strcmp(cmd, "prefetch") == 0)
+    socket_cmd = CMD_PREFETCH;
+  else if (strcmp(cmd, "stats") == 0)
+    socket_cmd = CMD_STATS;
   else
     return 1;
 
@@ -327,6 +514,14 @@ static int run_client(const char *cmd) {
             "Daemon not running. Start with: snappy-switcher --daemon\n");
     return 1;
   }
+
+  if (strcmp(socket_cmd, CMD_STATS) == 0) {
+    char reply[1024];
+    if (send_command_reply(socket_cmd, reply, sizeof(reply)) < 0)
+      return 1;
+    fputs(reply, stdout);
+    return 0;
+  }
   return send_command(socket_cmd) == 0 ? 0 : 1;
 }
 
@@ -398,7 +593,9 @@ static int run_daemon(void) {
   config = load_config();
   if (!config)
     config = get_default_config();
+  blit_init();
   render_set_config(config);
+  workers_init(config->render_threads, text_cleanup);
   icons_init(config->icon_theme, config->icon_fallback);
   app_state_init(&app_state);
 
@@ -442,6 +639,9 @@ static int run_daemon(void) {
     return 1;
   }
 
+  if (capture_available() && backend->request_previews)
+    backend->request_previews();
+
   /* 5. Surface Setup */
   surface = wl_compositor_create_surface(compositor);
   layer_surface = zwlr_layer_shell_v1_get_layer_surface(
@@ -465,19 +665,31 @@ static int run_daemon(void) {
 
   LOG("Daemon Started (PID: %d)", getpid());
 
-  struct pollfd fds[2];
+  struct pollfd fds[2 + BACKEND_MAX_POLL_FDS];
   fds[0].fd = wl_display_get_fd(display);
   fds[0].events = POLLIN;
   fds[1].fd = socket_fd;
   fds[1].events = POLLIN;
 
   while (running && !should_quit) {
+    /* Backend fds change as streams reconnect and replies complete */
+    int nbackend = backend->get_poll_fds
+                       ? backend->get_poll_fds(&fds[2], BACKEND_MAX_POLL_FDS)
+                       : 0;
+
     while (wl_display_prepare_read(display) != 0) {
       wl_display_dispatch_pending(display);
     }
     wl_display_flush(display);
 
-    if (poll(fds, 2, 100) < 0) {
+    int timeout = 100;
+    if (backend->get_timeout) {
+      int t = backend->get_timeout();
+      if (t >= 0 && t < timeout)
+        timeout = t;
+    }
+
+    if (poll(fds, 2 + nbackend, timeout) < 0) {
       if (errno == EINTR) {
         wl_display_cancel_read(display);
         continue;
@@ -492,6 +704,14 @@ static int run_daemon(void) {
       wl_display_cancel_read(display);
     }
 
+    bool backend_due = backend->get_timeout && backend->get_timeout() == 0;
+    for (int i = 2; i < 2 + nbackend && !backend_due; i++) {
+      if (fds[i].revents & (POLLIN | POLLOUT | POLLHUP | POLLERR))
+        backend_due = true;
+    }
+    if (backend_due && backend->dispatch_events && backend->dispatch_events())
+      reconcile_switcher();
+
     if (fds[1].revents & POLLIN) {
       while (1) {
         struct sockaddr_un cli_addr;
@@ -512,7 +732,7 @@ static int run_daemon(void) {
           if (buffer[n - 1] == '\n')
             buffer[n - 1] = '\0';
           LOG("Received command: %s", buffer);
-          handle_command(buffer);
+          handle_command(buffer, client);
         }
         close(client);
       }
@@ -526,6 +746,13 @@ static int run_daemon(void) {
     LOG("Cleaning up...");
   }
 
+  LOG("Prefetch hits: %lu, misses: %lu", prefetch_hits, prefetch_misses);
+  render_discard();
+  render_discard_kept();
+  workers_cleanup();
+  render_cleanup();
+  shm_pool_cleanup();
+  capture_cleanup();
   cleanup_server(socket_fd);
   input_cleanup();
   icons_cleanup();
@@ -536,6 +763,7 @@ static int run_daemon(void) {
     backend_cleanup(backend);
     backend = NULL;
   }
+  atoms_cleanup();
 
   if (layer_surface)
     zwlr_layer_surface_v1_destroy(layer_surface);
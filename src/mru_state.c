@@ -0,0 +1,126 @@
+/* src/mru_state.c - MRU history that survives daemon restarts */
+#define _POSIX_C_SOURCE 200809L
+
+#include "mru_state.h"
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define LOG(fmt, ...) fprintf(stderr, "[MRU] " fmt "\n", ##__VA_ARGS__)
+#define MRU_STATE_NAME "snappy-switcher-mru"
+#define MRU_STATE_MAGIC 0x554d5253u /* "SRMU" */
+#define MRU_STATE_VERSION 1
+
+typedef struct {
+  uint64_t fingerprint; /* 0 = empty slot */
+  uint64_t stamp;
+} MruRecord;
+
+typedef struct {
+  uint32_t magic;
+  uint32_t version;
+  uint64_t clock; /* Last stamp handed out */
+  MruRecord records[MRU_STATE_SLOTS];
+} MruStateFile;
+
+static MruStateFile *state = NULL;
+
+int mru_state_open(void) {
+  if (state)
+    return 0;
+
+  const char *xdg = getenv("XDG_RUNTIME_DIR");
+  if (!xdg || !xdg[0]) {
+    LOG("XDG_RUNTIME_DIR not set, MRU history will not persist");
+    return -1;
+  }
+
+  char path[512];
+  snprintf(path, sizeof(path), "%s/%s", xdg, MRU_STATE_NAME);
+
+  int fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+  if (fd < 0) {
+    LOG("Cannot open %s", path);
+    return -1;
+  }
+
+  /* A file of the wrong size is from another version; start over */
+  struct stat st;
+  bool fresh = fstat(fd, &st) < 0 || st.st_size != sizeof(MruStateFile);
+  if (fresh && ftruncate(fd, sizeof(MruStateFile)) < 0) {
+    LOG("Cannot size %s", path);
+    close(fd);
+    return -1;
+  }
+
+  void *map = mmap(NULL, sizeof(MruStateFile), PROT_READ | PROT_WRITE,
+                   MAP_SHARED, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED) {
+    LOG("Cannot map %s", path);
+    return -1;
+  }
+
+  state = map;
+  if (fresh || state->magic != MRU_STATE_MAGIC ||
+      state->version != MRU_STATE_VERSION) {
+    memset(state, 0, sizeof(*state));
+    state->magic = MRU_STATE_MAGIC;
+    state->version = MRU_STATE_VERSION;
+    LOG("Started new MRU history in %s", path);
+  }
+  return 0;
+}
+
+uint64_t mru_state_fingerprint(const char *app_id, const char *title) {
+  /* FNV-1a over app_id, a separator, then title */
+  uint64_t h = 0xcbf29ce484222325ull;
+  for (const char *p = app_id ? app_id : ""; *p; p++)
+    h = (h ^ (unsigned char)*p) * 0x100000001b3ull;
+  h = (h ^ 0xff) * 0x100000001b3ull;
+  for (const char *p = title ? title : ""; *p; p++)
+    h = (h ^ (unsigned char)*p) * 0x100000001b3ull;
+  return h ? h : 1;
+}
+
+uint64_t mru_state_lookup(uint64_t fingerprint) {
+  if (!state)
+    return 0;
+  for (int i = 0; i < MRU_STATE_SLOTS; i++) {
+    if (state->records[i].fingerprint == fingerprint)
+      return state->records[i].stamp;
+  }
+  return 0;
+}
+
+void mru_state_touch(uint64_t fingerprint) {
+  if (!state)
+    return;
+
+  MruRecord *slot = NULL;
+  for (int i = 0; i < MRU_STATE_SLOTS; i++) {
+    MruRecord *rec = &state->records[i];
+    if (rec->fingerprint == fingerprint) {
+      slot = rec;
+      break;
+    }
+    /* Empty slots have stamp 0 and are taken first */
+    if (!slot || rec->stamp < slot->stamp)
+      slot = rec;
+  }
+
+  slot->fingerprint = fingerprint;
+  slot->stamp = ++state->clock;
+}
+
+void mru_state_close(void) {
+  if (state) {
+    munmap(state, sizeof(MruStateFile));
+    state = NULL;
+  }
+}
@@ -0,0 +1,30 @@
+/* src/mru_state.h - MRU history that survives daemon restarts */
+#ifndef MRU_STATE_H
+#define MRU_STATE_H
+
+#include <stdint.h>
+
+/*
+ * Windows are remembered by a fingerprint of (app_id, title) together with
+ * a stamp from a clock that only moves forward: a larger stamp means the
+ * window was focused more recently. The table lives in a fixed-size file
+ * under $XDG_RUNTIME_DIR that is mmap'd, so recording a focus change is a
+ * plain memory store and the kernel writes it back on its own.
+ */
+#define MRU_STATE_SLOTS 256
+
+/* Map the state file, creating or resetting it if needed */
+int mru_state_open(void);
+
+/* Stable 64-bit fingerprint of a window (never 0) */
+uint64_t mru_state_fingerprint(const char *app_id, const char *title);
+
+/* Stamp recorded for a fingerprint, 0 if unknown or no state file */
+uint64_t mru_state_lookup(uint64_t fingerprint);
+
+/* Record the window as focused now (evicts the oldest entry when full) */
+void mru_state_touch(uint64_t fingerprint);
+
+void mru_state_close(void);
+
+#endif /* MRU_STATE_H */
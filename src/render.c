@@ -3,19 +3,22 @@
 #define _USE_MATH_DEFINES
 
 #include "render.h"
+#include "blit.h"
 #include "config.h"
+#include "icon_atlas.h"
 #include "icons.h"
+#include "shm_pool.h"
+#include "sprite_cache.h"
+#include "text.h"
+#include "workers.h"
+#include "thumbnail.h"
 #include <cairo/cairo.h>
 #include <ctype.h>
-#include <fcntl.h>
 #include <math.h>
 #include <pango/pangocairo.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <strings.h>
-#include <sys/mman.h>
-#include <unistd.h>
 
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
@@ -25,6 +28,43 @@
 
 static Config *cfg = NULL;
 
+/* Frames go to the layer surface unless render_set_sink() says otherwise */
+static void wayland_present(ShmBuffer *frame, const RenderRect *damage, int n);
+static const RenderSink wayland_sink = {
+    .acquire = shm_pool_acquire,
+    .release = shm_pool_release,
+    .present = wayland_present,
+};
+static const RenderSink *sink = &wayland_sink;
+
+/* Frame rendered off-screen, waiting to be attached by render_present() */
+static ShmBuffer *prepared = NULL;
+static ShmBuffer *kept = NULL; /* Retained by render_present(keep) */
+
+/*
+ * Frame pacing: after a commit, further redraws wait for the compositor's
+ * frame callback, and only the latest state is drawn then.
+ */
+static struct wl_callback *frame_callback = NULL;
+static AppState *dirty_state = NULL;
+
+/* Panel background and border, drawn once per size and theme */
+static cairo_surface_t *background = NULL;
+
+/* Everything a baked icon depends on; the atlas is rebuilt when it changes */
+typedef struct {
+  int size;
+  int radius;
+  int letter_size;
+  bool letters;
+  char icon_theme[64];
+  char icon_fallback[64];
+  char font_family[64];
+  char font_weight[32];
+} AtlasKey;
+
+static AtlasKey atlas_key;
+
 /* Palette for letter icon fallbacks */
 static const uint32_t icon_colors[] = {
     0xe78284, /* Red */
@@ -37,47 +77,54 @@ static const uint32_t icon_colors[] = {
 };
 #define NUM_ICON_COLORS (sizeof(icon_colors) / sizeof(icon_colors[0]))
 
-void render_set_config(Config *config) { cfg = config; }
+#define BADGE_TEXT_SIZE 10
+#define MESSAGE_TEXT_SIZE 16
 
-int create_shm_file(off_t size) {
-  char name[] = "/tmp/snappy-shm-XXXXXX";
-  int fd = mkstemp(name);
-  if (fd < 0)
-    return -1;
-  unlink(name);
-  if (ftruncate(fd, size) < 0) {
-    close(fd);
-    return -1;
-  }
-  return fd;
+static void drop_caches(void) {
+  sprite_cache_clear();
+  if (background)
+    cairo_surface_destroy(background);
+  background = NULL;
 }
 
-static unsigned int hash_string(const char *str) {
-  unsigned int hash = 5381;
-  int c;
-  while ((c = *str++))
-    hash = ((hash << 5) + hash) + c;
-  return hash;
-}
-
-/* Helper to start Pango layout with config font */
-static PangoLayout *create_layout(cairo_t *cr, int size) {
-  PangoLayout *layout = pango_cairo_create_layout(cr);
-  PangoFontDescription *desc = pango_font_description_new();
+static void reset_icon_atlas(void) {
+  AtlasKey key = {0};
+  key.size = cfg ? cfg->icon_size : 64;
+  key.radius = cfg ? cfg->icon_radius : 12;
+  key.letter_size = cfg ? cfg->icon_letter_size : 28;
+  key.letters = cfg ? cfg->show_letter_fallback : true;
+  if (cfg) {
+    memcpy(key.icon_theme, cfg->icon_theme, sizeof(key.icon_theme));
+    memcpy(key.icon_fallback, cfg->icon_fallback, sizeof(key.icon_fallback));
+    memcpy(key.font_family, cfg->font_family, sizeof(key.font_family));
+    memcpy(key.font_weight, cfg->font_weight, sizeof(key.font_weight));
+  }
 
-  const char *family = cfg ? cfg->font_family : "Sans";
-  const char *weight_str = cfg ? cfg->font_weight : "Bold";
-  PangoWeight weight = PANGO_WEIGHT_BOLD;
-  if (strcasecmp(weight_str, "Normal") == 0)
-    weight = PANGO_WEIGHT_NORMAL;
+  if (icon_atlas_surface() && memcmp(&key, &atlas_key, sizeof(key)) == 0)
+    return;
+  atlas_key = key;
+  icon_atlas_reset(key.size);
+}
 
-  pango_font_description_set_family(desc, family);
-  pango_font_description_set_weight(desc, weight);
-  pango_font_description_set_size(desc, size * PANGO_SCALE);
+void render_set_config(Config *config) {
+  cfg = config;
+  render_invalidate();
+  drop_caches();
+  reset_icon_atlas();
+
+  /* Every text size a frame can use, resolved up front */
+  int sizes[] = {cfg ? cfg->title_size : 12, cfg ? cfg->icon_letter_size : 28,
+                 BADGE_TEXT_SIZE, MESSAGE_TEXT_SIZE};
+  text_set_font(cfg ? cfg->font_family : "Sans",
+                cfg ? cfg->font_weight : "Bold", sizes,
+                sizeof(sizes) / sizeof(sizes[0]));
+}
 
-  pango_layout_set_font_description(layout, desc);
-  pango_font_description_free(desc);
-  return layout;
+void render_cleanup(void) {
+  drop_caches();
+  sprite_cache_cleanup();
+  icon_atlas_cleanup();
+  text_cleanup();
 }
 
 static void draw_rounded_rect(cairo_t *cr, double x, double y, double w,
@@ -96,24 +143,74 @@ static void draw_rounded_rect(cairo_t *cr, double x, double y, double w,
   cairo_close_path(cr);
 }
 
-static void draw_letter_icon(cairo_t *cr, const char *cls, double cx, double cy,
+/* An ARGB32 image surface's pixels, all writable; false for anything else */
+static bool surface_image(cairo_surface_t *surf, BlitImage *img) {
+  if (cairo_surface_get_type(surf) != CAIRO_SURFACE_TYPE_IMAGE ||
+      cairo_image_surface_get_format(surf) != CAIRO_FORMAT_ARGB32)
+    return false;
+  cairo_surface_flush(surf);
+  img->data = cairo_image_surface_get_data(surf);
+  if (!img->data)
+    return false;
+  img->stride = cairo_image_surface_get_stride(surf);
+  img->width = cairo_image_surface_get_width(surf);
+  img->height = cairo_image_surface_get_height(surf);
+  img->x0 = 0;
+  img->y0 = 0;
+  img->x1 = img->width;
+  img->y1 = img->height;
+  return true;
+}
+
+/*
+ * The pixels cr draws to, limited to its clip (only ever a rectangle
+ * here). Blits into it must be followed by cairo_surface_mark_dirty().
+ */
+static bool target_image(cairo_t *cr, BlitImage *img) {
+  if (!surface_image(cairo_get_target(cr), img))
+    return false;
+
+  double x0, y0, x1, y1;
+  cairo_clip_extents(cr, &x0, &y0, &x1, &y1);
+  img->x0 = x0 > 0 ? (int)floor(x0) : 0;
+  img->y0 = y0 > 0 ? (int)floor(y0) : 0;
+  img->x1 = x1 < img->width ? (int)ceil(x1) : img->width;
+  img->y1 = y1 < img->height ? (int)ceil(y1) : img->height;
+  return true;
+}
+
+/* Flat rounded fill, straight into the pixels when cr draws to an image */
+static void fill_rounded_rect(cairo_t *cr, double x, double y, double w,
+                              double h, double r, double red, double green,
+                              double blue, double alpha) {
+  BlitImage img;
+  if (target_image(cr, &img)) {
+    blit_fill_rounded(&img, x, y, w, h, r, red, green, blue, alpha);
+    cairo_surface_mark_dirty(cairo_get_target(cr));
+    return;
+  }
+  cairo_set_source_rgba(cr, red, green, blue, alpha);
+  draw_rounded_rect(cr, x, y, w, h, r);
+  cairo_fill(cr);
+}
+
+static void draw_letter_icon(cairo_t *cr, Atom cls, double cx, double cy,
                              int size, int radius, int letter_size) {
   cairo_save(cr);
   cairo_new_path(cr);
 
   /* Background */
-  uint32_t color = icon_colors[hash_string(cls) % NUM_ICON_COLORS];
+  uint32_t color = icon_colors[atom_hash(cls) % NUM_ICON_COLORS];
   double r, g, b;
   color_to_rgb(color, &r, &g, &b);
 
-  cairo_set_source_rgb(cr, r, g, b);
-  draw_rounded_rect(cr, cx - size / 2.0, cy - size / 2.0, size, size, radius);
-  cairo_fill(cr);
+  fill_rounded_rect(cr, cx - size / 2.0, cy - size / 2.0, size, size, radius,
+                    r, g, b, 1);
 
   /* Letter */
-  char letter[2] = {cls && cls[0] ? toupper(cls[0]) : '?', 0};
-  PangoLayout *layout = create_layout(cr, letter_size);
-  pango_layout_set_text(layout, letter, -1);
+  const char *name = atom_name(cls);
+  char letter[2] = {name[0] ? toupper((unsigned char)name[0]) : '?', 0};
+  PangoLayout *layout = text_layout(letter, letter_size, 0);
 
   int lw, lh;
   pango_layout_get_pixel_size(layout, &lw, &lh);
@@ -122,40 +219,132 @@ static void draw_letter_icon(cairo_t *cr, const char *cls, double cx, double cy,
   cairo_move_to(cr, cx - lw / 2.0, cy - lh / 2.0);
   pango_cairo_show_layout(cr, layout);
 
-  g_object_unref(layout);
   cairo_restore(cr);
 }
 
-static void draw_icon(cairo_t *cr, const char *cls, double cx, double cy) {
+/*
+ * What a card shows from the daemon thread's caches, looked up before the
+ * card is drawn so that drawing itself can run on any thread.
+ */
+typedef struct {
+  BlitImage icon;           /* Atlas cell; data NULL draws no icon */
+  const Thumbnail *preview; /* Shown instead of the icon when set */
+} CardArt;
+
+/*
+ * Draw cls's icon, or its letter fallback, into a fresh atlas cell with
+ * the icon_radius corners already cut. False if it has neither; the cell
+ * is then left blank so the icon theme is searched once per class.
+ */
+static bool bake_icon(Atom cls) {
   int size = cfg ? cfg->icon_size : 64;
   int radius = cfg ? cfg->icon_radius : 12;
 
-  cairo_save(cr);
-
   cairo_surface_t *icon = load_app_icon(cls, size);
-  if (icon && cairo_surface_status(icon) == CAIRO_STATUS_SUCCESS) {
-    /* Clip mask */
-    draw_rounded_rect(cr, cx - size / 2.0, cy - size / 2.0, size, size, radius);
-    cairo_clip(cr);
+  if (icon && cairo_surface_status(icon) != CAIRO_STATUS_SUCCESS) {
+    cairo_surface_destroy(icon);
+    icon = NULL;
+  }
+  if (!icon && cfg && !cfg->show_letter_fallback) {
+    icon_atlas_insert_blank(cls);
+    return false;
+  }
+  int x, y;
+  if (!icon_atlas_insert(cls, &x, &y)) {
+    if (icon)
+      cairo_surface_destroy(icon);
+    return false;
+  }
 
-    cairo_set_source_surface(cr, icon, cx - size / 2.0, cy - size / 2.0);
+  cairo_t *cr = cairo_create(icon_atlas_surface());
+  cairo_set_antialias(cr, CAIRO_ANTIALIAS_BEST);
+  cairo_rectangle(cr, x, y, size, size);
+  cairo_clip(cr);
+  if (icon) {
+    draw_rounded_rect(cr, x, y, size, size, radius);
+    cairo_clip(cr);
+    cairo_set_source_surface(cr, icon, x, y);
     cairo_paint(cr);
     cairo_surface_destroy(icon);
   } else {
-    /* Fallback */
-    if (icon)
-      cairo_surface_destroy(icon);
-    if (!cfg || cfg->show_letter_fallback) {
-      draw_letter_icon(cr, cls, cx, cy, size, radius,
-                       cfg ? cfg->icon_letter_size : 28);
-    }
+    draw_letter_icon(cr, cls, x + size / 2.0, y + size / 2.0, size, radius,
+                     cfg ? cfg->icon_letter_size : 28);
+  }
+  cairo_destroy(cr);
+  cairo_surface_flush(icon_atlas_surface());
+  return true;
+}
+
+static void card_art_get(const WindowInfo *win, CardArt *art) {
+  art->preview =
+      (cfg && cfg->show_previews) ? thumbs_lookup(win->address) : NULL;
+  art->icon.data = NULL;
+  if (art->preview)
+    return;
+
+  if (!icon_atlas_lookup(win->class_atom, &art->icon) &&
+      (!bake_icon(win->class_atom) ||
+       !icon_atlas_lookup(win->class_atom, &art->icon)))
+    art->icon.data = NULL;
+}
+
+/* Blit a baked icon centred on (cx, cy), snapped to whole pixels */
+static void draw_icon(cairo_t *cr, const BlitImage *icon, double cx,
+                      double cy) {
+  int x = (int)floor(cx - icon->width / 2.0 + 0.5);
+  int y = (int)floor(cy - icon->height / 2.0 + 0.5);
+
+  BlitImage dst;
+  if (target_image(cr, &dst)) {
+    blit_over(&dst, icon, x, y);
+    cairo_surface_mark_dirty(cairo_get_target(cr));
+    return;
+  }
+
+  cairo_surface_t *img = cairo_image_surface_create_for_data(
+      icon->data, CAIRO_FORMAT_ARGB32, icon->width, icon->height,
+      icon->stride);
+  cairo_set_source_surface(cr, img, x, y);
+  cairo_paint(cr);
+  cairo_surface_destroy(img);
+}
+
+/* Window preview fitted (and centred) into the given box */
+static bool draw_preview(cairo_t *cr, const Thumbnail *thumb, double x,
+                         double y, double w, double h, double radius) {
+  if (!thumb || w <= 0 || h <= 0)
+    return false;
+
+  cairo_surface_t *img = cairo_image_surface_create_for_data(
+      (unsigned char *)thumb->pixels, CAIRO_FORMAT_ARGB32, thumb->width,
+      thumb->height, thumb->width * 4);
+  if (cairo_surface_status(img) != CAIRO_STATUS_SUCCESS) {
+    cairo_surface_destroy(img);
+    return false;
   }
 
+  double scale = fmin(w / thumb->width, h / thumb->height);
+  double pw = thumb->width * scale;
+  double ph = thumb->height * scale;
+  double px = x + (w - pw) / 2.0;
+  double py = y + (h - ph) / 2.0;
+
+  cairo_save(cr);
+  draw_rounded_rect(cr, px, py, pw, ph, radius);
+  cairo_clip(cr);
+  cairo_translate(cr, px, py);
+  cairo_scale(cr, scale, scale);
+  cairo_set_source_surface(cr, img, 0, 0);
+  cairo_pattern_set_filter(cairo_get_source(cr), CAIRO_FILTER_GOOD);
+  cairo_paint(cr);
   cairo_restore(cr);
+
+  cairo_surface_destroy(img);
+  return true;
 }
 
-static void draw_card(cairo_t *cr, WindowInfo *win, double x, double y,
-                      bool selected) {
+static void draw_card(cairo_t *cr, const WindowInfo *win, const CardArt *art,
+                      double x, double y, bool selected) {
   cairo_save(cr);
 
   double bg_r, bg_g, bg_b;
@@ -176,23 +365,15 @@ static void draw_card(cairo_t *cr, WindowInfo *win, double x, double y,
 
   /* Stack effect (Context Mode) */
   if (win->group_count > 1) {
-    cairo_set_source_rgba(cr, bg_r, bg_g, bg_b, 0.5);
-    draw_rounded_rect(cr, x + 6, y + 6, w, h, r);
-    cairo_fill(cr);
-
-    cairo_set_source_rgba(cr, bg_r, bg_g, bg_b, 0.7);
-    draw_rounded_rect(cr, x + 3, y + 3, w, h, r);
-    cairo_fill(cr);
+    fill_rounded_rect(cr, x + 6, y + 6, w, h, r, bg_r, bg_g, bg_b, 0.5);
+    fill_rounded_rect(cr, x + 3, y + 3, w, h, r, bg_r, bg_g, bg_b, 0.7);
   }
 
   /* Main Card */
   if (selected)
-    cairo_set_source_rgb(cr, sel_r, sel_g, sel_b);
+    fill_rounded_rect(cr, x, y, w, h, r, sel_r, sel_g, sel_b, 1);
   else
-    cairo_set_source_rgb(cr, bg_r, bg_g, bg_b);
-
-  draw_rounded_rect(cr, x, y, w, h, r);
-  cairo_fill(cr);
+    fill_rounded_rect(cr, x, y, w, h, r, bg_r, bg_g, bg_b, 1);
 
   /* Border */
   if (selected) {
@@ -203,20 +384,20 @@ static void draw_card(cairo_t *cr, WindowInfo *win, double x, double y,
   }
 
   /* Title */
-  PangoLayout *title = create_layout(cr, cfg ? cfg->title_size : 12);
-  pango_layout_set_width(title, (w - 20) * PANGO_SCALE);
-  pango_layout_set_ellipsize(title, PANGO_ELLIPSIZE_END);
-  pango_layout_set_alignment(title, PANGO_ALIGN_CENTER);
-  pango_layout_set_text(title, win->title, -1);
+  PangoLayout *title =
+      text_layout(win->title, cfg ? cfg->title_size : 12, w - 20);
 
   cairo_set_source_rgb(cr, txt_r, txt_g, txt_b);
   cairo_move_to(cr, x + 10, y + 10);
   pango_cairo_show_layout(cr, title);
-  g_object_unref(title);
 
-  /* Icon */
-  draw_icon(cr, win->class_name, x + w / 2.0,
-            y + 10 + 20 + 10 + (cfg ? cfg->icon_size / 2.0 : 32));
+  /* Preview (when captured), else Icon */
+  bool previewed = cfg && cfg->show_previews &&
+                   draw_preview(cr, art->preview, x + 10, y + 40, w - 20,
+                                h - 50, cfg->icon_radius);
+  if (!previewed && art->icon.data)
+    draw_icon(cr, &art->icon, x + w / 2.0,
+              y + 10 + 20 + 10 + (cfg ? cfg->icon_size / 2.0 : 32));
 
   /* Badge (Count) */
   if (win->group_count > 1) {
@@ -232,8 +413,7 @@ static void draw_card(cairo_t *cr, WindowInfo *win, double x, double y,
     cairo_fill(cr);
 
     /* Badge Text (Config Text Color) */
-    PangoLayout *bl = create_layout(cr, 10);
-    pango_layout_set_text(bl, count, -1);
+    PangoLayout *bl = text_layout(count, BADGE_TEXT_SIZE, 0);
 
     int bw, bh;
     pango_layout_get_pixel_size(bl, &bw, &bh);
@@ -242,12 +422,17 @@ static void draw_card(cairo_t *cr, WindowInfo *win, double x, double y,
     cairo_set_source_rgb(cr, txt_r, txt_g, txt_b);
     cairo_move_to(cr, bx - bw / 2.0, by - bh / 2.0);
     pango_cairo_show_layout(cr, bl);
-    g_object_unref(bl);
   }
 
   cairo_restore(cr);
 }
 
+/* Rows in view: all of them unless max_rows caps the panel */
+static int visible_rows(int rows) {
+  int max = cfg ? cfg->max_rows : 0;
+  return (max > 0 && rows > max) ? max : rows;
+}
+
 void calculate_dimensions(AppState *state, uint32_t *width, uint32_t *height) {
   int count = (state && state->count > 0) ? state->count : 1;
   int w = cfg ? cfg->card_width : 200;
@@ -258,7 +443,7 @@ void calculate_dimensions(AppState *state, uint32_t *width, uint32_t *height) {
 
   if (count < cols)
     cols = count;
-  int rows = (count + cols - 1) / cols;
+  int rows = visible_rows((count + cols - 1) / cols);
 
   *width = (cols * w) + ((cols - 1) * gap) + (pad * 2);
   *height = (rows * h) + ((rows - 1) * gap) + (pad * 2);
@@ -269,33 +454,270 @@ void calculate_dimensions(AppState *state, uint32_t *width, uint32_t *height) {
     *height = 150;
 }
 
-void render_ui(AppState *state, uint32_t width, uint32_t height) {
-  int stride = cairo_format_stride_for_width(CAIRO_FORMAT_ARGB32, width);
-  int size = stride * height;
-  int fd = create_shm_file(size);
-  if (fd < 0)
-    return;
+/* Hand the buffer back to the pool; it is reused once the compositor
+ * releases it */
+static void frame_release(ShmBuffer **frame) {
+  if (*frame)
+    sink->release(*frame);
+  *frame = NULL;
+}
 
-  void *data = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
-  if (data == MAP_FAILED) {
-    close(fd);
-    return;
+void render_discard(void) { frame_release(&prepared); }
+
+void render_discard_kept(void) { frame_release(&kept); }
+
+/*
+ * What a pool buffer was last drawn with. Frames of one snapshot differ
+ * only in their selected card, so a buffer holding one selection becomes
+ * another by repainting two cards.
+ */
+typedef struct {
+  const ShmBuffer *buf;
+  uint64_t content; /* content_serial when drawn, 0 = nothing */
+  uint64_t thumbs;  /* previews_stamp() when drawn */
+  const WindowInfo *windows;
+  int count;
+  int selected;
+  int first_row;
+  uint32_t width;
+  uint32_t height;
+} FrameTag;
+
+static FrameTag frame_tags[SHM_POOL_BUFFERS];
+static FrameTag shown; /* Frame last attached to the surface */
+static uint64_t content_serial = 1;
+
+/* Card grid placement, shared by full and partial redraws */
+typedef struct {
+  int card_w;
+  int card_h;
+  int gap;
+  int max_cols;
+  int rows;      /* In the whole grid */
+  int view_rows; /* In view, from first_row on */
+  int first;     /* Cards first .. last - 1 are in view */
+  int last;
+  double x; /* First card in view */
+  double y;
+} Grid;
+
+/* The pool has SHM_POOL_BUFFERS fixed buffers, so a tag is always found */
+static FrameTag *frame_tag(const ShmBuffer *buf) {
+  FrameTag *unused = NULL;
+  for (int i = 0; i < SHM_POOL_BUFFERS; i++) {
+    if (frame_tags[i].buf == buf)
+      return &frame_tags[i];
+    if (!frame_tags[i].buf && !unused)
+      unused = &frame_tags[i];
+  }
+  memset(unused, 0, sizeof(*unused));
+  unused->buf = buf;
+  return unused;
+}
+
+/*
+ * Fingerprint of the previews the snapshot's cards show. Captures of
+ * other windows leave it unchanged, so they don't invalidate frames.
+ */
+static uint64_t previews_stamp(const AppState *state) {
+  static uint64_t stamp, thumbs, content;
+  static const WindowInfo *windows;
+  static int count;
+
+  if (!state || !cfg || !cfg->show_previews)
+    return 0;
+  if (content == content_serial && thumbs == thumbs_generation() &&
+      windows == state->windows && count == state->count)
+    return stamp;
+
+  content = content_serial;
+  thumbs = thumbs_generation();
+  windows = state->windows;
+  count = state->count;
+  stamp = 14695981039346656037ull;
+  for (int i = 0; i < state->count; i++) {
+    const Thumbnail *thumb = thumbs_lookup(state->windows[i].address);
+    stamp = (stamp ^ (thumb ? thumb->generation : 0)) * 1099511628211ull;
   }
+  return stamp;
+}
 
-  /* CRITICAL FIX 1: Zero buffer */
-  memset(data, 0, size);
+static void tag_frame(const ShmBuffer *buf, const AppState *state) {
+  FrameTag *tag = frame_tag(buf);
+  tag->content = content_serial;
+  tag->thumbs = previews_stamp(state);
+  tag->windows = state ? state->windows : NULL;
+  tag->count = state ? state->count : 0;
+  tag->selected = state ? state->selected_index : 0;
+  tag->first_row = state ? state->first_row : 0;
+  tag->width = buf->width;
+  tag->height = buf->height;
+}
 
-  cairo_surface_t *surf = cairo_image_surface_create_for_data(
-      data, CAIRO_FORMAT_ARGB32, width, height, stride);
-  cairo_t *cr = cairo_create(surf);
-  cairo_set_antialias(cr, CAIRO_ANTIALIAS_BEST);
+/* The tagged frame shows this snapshot, whatever its selection */
+static bool frame_shows(const FrameTag *tag, const AppState *state,
+                        uint32_t width, uint32_t height) {
+  return tag->content == content_serial &&
+         tag->thumbs == previews_stamp(state) &&
+         tag->windows == state->windows && tag->count == state->count &&
+         tag->first_row == state->first_row && tag->width == width &&
+         tag->height == height;
+}
 
-  /* CRITICAL FIX 2: Source Clear */
-  cairo_set_operator(cr, CAIRO_OPERATOR_SOURCE);
-  cairo_set_source_rgba(cr, 0, 0, 0, 0);
-  cairo_paint(cr);
-  cairo_set_operator(cr, CAIRO_OPERATOR_OVER);
+void render_invalidate(void) { content_serial++; }
+
+static void grid_layout(const AppState *state, uint32_t width,
+                        uint32_t height, Grid *g) {
+  int pad = cfg ? cfg->padding : 32;
+  g->card_w = cfg ? cfg->card_width : 200;
+  g->card_h = cfg ? cfg->card_height : 160;
+  g->gap = cfg ? cfg->card_gap : 12;
+  g->max_cols = cfg ? cfg->max_cols : 5;
+
+  int cols = (state->count < g->max_cols) ? state->count : g->max_cols;
+  g->rows = (state->count + g->max_cols - 1) / g->max_cols;
+  g->view_rows = visible_rows(g->rows);
+  g->first = state->first_row * g->max_cols;
+  g->last = g->first + g->view_rows * g->max_cols;
+  if (g->last > state->count)
+    g->last = state->count;
+
+  int grid_w = (cols * g->card_w) + ((cols - 1) * g->gap);
+  int grid_h = (g->view_rows * g->card_h) + ((g->view_rows - 1) * g->gap);
+
+  g->x = (width - grid_w) / 2.0;
+  g->y = (height - grid_h) / 2.0;
+  if (g->x < pad)
+    g->x = pad;
+  if (g->y < pad)
+    g->y = pad;
+}
+
+static void card_origin(const Grid *g, int i, double *x, double *y) {
+  i -= g->first;
+  *x = g->x + (i % g->max_cols) * (g->card_w + g->gap);
+  *y = g->y + (i / g->max_cols) * (g->card_h + g->gap);
+}
+
+/*
+ * With more rows than max_rows, scroll just far enough that the selected
+ * card's row is in view, and never past the last row.
+ */
+static void follow_selection(AppState *state) {
+  int cols = cfg ? cfg->max_cols : 5;
+  int rows = (state->count + cols - 1) / cols;
+  int view = visible_rows(rows);
+  int row = state->selected_index / cols;
+
+  if (row < state->first_row)
+    state->first_row = row;
+  else if (row >= state->first_row + view)
+    state->first_row = row - view + 1;
+  if (state->first_row > rows - view)
+    state->first_row = rows - view;
+  if (state->first_row < 0)
+    state->first_row = 0;
+}
+
+/*
+ * Pixels draw_card() may touch around the card: stack cards reach 6px
+ * right and down, the selection border half its width out, plus a pixel
+ * of antialiasing.
+ */
+static int card_margin(void) {
+  return ((cfg ? cfg->border_width : 2) + 1) / 2 + 1;
+}
+
+static RenderRect card_extent(const Grid *g, int i, uint32_t width,
+                              uint32_t height) {
+  double x, y;
+  card_origin(g, i, &x, &y);
+  int m = card_margin();
+
+  int x0 = (int)floor(x) - m;
+  int y0 = (int)floor(y) - m;
+  int x1 = (int)ceil(x + g->card_w) + 6 + m;
+  int y1 = (int)ceil(y + g->card_h) + 6 + m;
+  if (x0 < 0)
+    x0 = 0;
+  if (y0 < 0)
+    y0 = 0;
+  if (x1 > (int)width)
+    x1 = width;
+  if (y1 > (int)height)
+    y1 = height;
+  return (RenderRect){x0, y0, x1 - x0, y1 - y0};
+}
+
+static bool rects_overlap(const RenderRect *a, const RenderRect *b) {
+  return a->x < b->x + b->w && b->x < a->x + a->w && a->y < b->y + b->h &&
+         b->y < a->y + a->h;
+}
+
+static void frame_done(void *data, struct wl_callback *cb, uint32_t time) {
+  (void)data;
+  (void)time;
+  wl_callback_destroy(cb);
+  frame_callback = NULL;
+
+  if (dirty_state) {
+    AppState *state = dirty_state;
+    render_ui(state, state->width, state->height);
+  }
+}
+
+static const struct wl_callback_listener frame_listener = {
+    .done = frame_done,
+};
+
+/* Attach and commit; damage only the given rects, or everything if none */
+static void wayland_present(ShmBuffer *frame, const RenderRect *damage,
+                            int n) {
+  wl_surface_attach(surface, frame->buffer, 0, 0);
+  /* Use damage_buffer for best safety */
+  if (n == 0)
+    wl_surface_damage_buffer(surface, 0, 0, frame->width, frame->height);
+  for (int i = 0; i < n; i++)
+    wl_surface_damage_buffer(surface, damage[i].x, damage[i].y, damage[i].w,
+                             damage[i].h);
+  if (!frame_callback) {
+    frame_callback = wl_surface_frame(surface);
+    wl_callback_add_listener(frame_callback, &frame_listener, NULL);
+  }
+  wl_surface_commit(surface);
+  shm_pool_attached(frame);
+}
+
+static void attach_frame(ShmBuffer *frame, const RenderRect *damage, int n) {
+  sink->present(frame, damage, n);
+  shown = *frame_tag(frame);
+}
+
+void render_set_sink(const RenderSink *new_sink) {
+  render_discard();
+  render_discard_kept();
+  render_cancel_frame();
+  sink = new_sink ? new_sink : &wayland_sink;
+
+  /* Tags name the old sink's buffers */
+  memset(frame_tags, 0, sizeof(frame_tags));
+  memset(&shown, 0, sizeof(shown));
+  render_invalidate();
+}
+
+/* Every buffer may be on screen or kept; the kept frame is expendable */
+static ShmBuffer *acquire_frame(uint32_t width, uint32_t height) {
+  ShmBuffer *buf = sink->acquire(width, height);
+  if (!buf && kept) {
+    render_discard_kept();
+    buf = sink->acquire(width, height);
+  }
+  if (!buf)
+    LOG("No free buffer for a %ux%u frame", width, height);
+  return buf;
+}
 
+static void draw_background(cairo_t *cr, uint32_t width, uint32_t height) {
   /* Background */
   double r, g, b;
   if (cfg)
@@ -306,10 +728,8 @@ void render_ui(AppState *state, uint32_t width, uint32_t height) {
     b = 0.2;
   }
 
-  cairo_set_source_rgba(cr, r, g, b, 0.95);
   int rad = cfg ? cfg->card_radius : 12;
-  draw_rounded_rect(cr, 0, 0, width, height, rad + 4);
-  cairo_fill(cr);
+  fill_rounded_rect(cr, 0, 0, width, height, rad + 4, r, g, b, 0.95);
 
   /* Border */
   if (cfg)
@@ -318,11 +738,263 @@ void render_ui(AppState *state, uint32_t width, uint32_t height) {
   cairo_set_line_width(cr, 1);
   draw_rounded_rect(cr, 0.5, 0.5, width - 1, height - 1, rad + 4);
   cairo_stroke(cr);
+}
+
+static cairo_surface_t *panel_background(uint32_t width, uint32_t height) {
+  if (background && (uint32_t)cairo_image_surface_get_width(background) ==
+                        width &&
+      (uint32_t)cairo_image_surface_get_height(background) == height)
+    return background;
+
+  if (background)
+    cairo_surface_destroy(background);
+  background = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, width, height);
+  if (cairo_surface_status(background) != CAIRO_STATUS_SUCCESS) {
+    cairo_surface_destroy(background);
+    background = NULL;
+    return NULL;
+  }
+  cairo_t *cr = cairo_create(background);
+  cairo_set_antialias(cr, CAIRO_ANTIALIAS_BEST);
+  draw_background(cr, width, height);
+  cairo_destroy(cr);
+  cairo_surface_flush(background);
+  return background;
+}
+
+/* Replace what is under the clip with the panel background */
+static void paint_background(cairo_t *cr, uint32_t width, uint32_t height) {
+  cairo_surface_t *bg = panel_background(width, height);
+  BlitImage dst, src;
+  if (bg && target_image(cr, &dst) && surface_image(bg, &src)) {
+    blit_copy(&dst, &src);
+    cairo_surface_mark_dirty(cairo_get_target(cr));
+    return;
+  }
+
+  cairo_set_operator(cr, CAIRO_OPERATOR_SOURCE);
+  if (bg)
+    cairo_set_source_surface(cr, bg, 0, 0);
+  else
+    cairo_set_source_rgba(cr, 0, 0, 0, 0);
+  cairo_paint(cr);
+  cairo_set_operator(cr, CAIRO_OPERATOR_OVER);
+  if (!bg)
+    draw_background(cr, width, height);
+}
+
+static void sprite_key(const WindowInfo *win, bool selected, double x,
+                       double y, SpriteKey *key) {
+  const Thumbnail *thumb =
+      (cfg && cfg->show_previews) ? thumbs_lookup(win->address) : NULL;
+  key->title = win->title;
+  key->class_atom = win->class_atom;
+  key->group_count = win->group_count;
+  key->selected = selected;
+  key->preview = thumb ? thumb->generation : 0;
+  key->phase_x = x - floor(x);
+  key->phase_y = y - floor(y);
+}
+
+/*
+ * Draw a card into a new sprite at the key's subpixel phase, NULL if out
+ * of memory. Safe on any thread.
+ */
+static cairo_surface_t *draw_sprite(const WindowInfo *win, const CardArt *art,
+                                    const SpriteKey *key) {
+  int w = cfg ? cfg->card_width : 200;
+  int h = cfg ? cfg->card_height : 160;
+  int m = card_margin();
+
+  cairo_surface_t *sprite = cairo_image_surface_create(
+      CAIRO_FORMAT_ARGB32, (int)ceil(key->phase_x + w) + 6 + 2 * m,
+      (int)ceil(key->phase_y + h) + 6 + 2 * m);
+  if (cairo_surface_status(sprite) != CAIRO_STATUS_SUCCESS) {
+    cairo_surface_destroy(sprite);
+    return NULL;
+  }
+
+  cairo_t *cr = cairo_create(sprite);
+  cairo_set_antialias(cr, CAIRO_ANTIALIAS_BEST);
+  draw_card(cr, win, art, m + key->phase_x, m + key->phase_y, key->selected);
+  cairo_destroy(cr);
+  cairo_surface_flush(sprite);
+  return sprite;
+}
+
+/*
+ * Blit the card's sprite, drawing it first on a miss. The sprite is drawn
+ * at the card's subpixel phase and placed on whole pixels, so it matches
+ * drawing the card in place.
+ */
+static void blit_card(cairo_t *cr, WindowInfo *win, double x, double y,
+                      bool selected) {
+  SpriteKey key;
+  sprite_key(win, selected, x, y, &key);
+
+  cairo_surface_t *sprite = sprite_cache_lookup(&key);
+  bool drawn = false;
+  if (!sprite) {
+    CardArt art;
+    card_art_get(win, &art);
+    sprite = draw_sprite(win, &art, &key);
+    if (!sprite) {
+      /* Out of memory: draw in place, uncached */
+      draw_card(cr, win, &art, x, y, selected);
+      return;
+    }
+    drawn = true;
+  }
+
+  int m = card_margin();
+  BlitImage dst, src;
+  if (target_image(cr, &dst) && surface_image(sprite, &src)) {
+    blit_over(&dst, &src, (int)floor(x) - m, (int)floor(y) - m);
+    cairo_surface_mark_dirty(cairo_get_target(cr));
+  } else {
+    cairo_set_source_surface(cr, sprite, floor(x) - m, floor(y) - m);
+    cairo_paint(cr);
+  }
+
+  /* Stored last: the cache may drop it at once if out of memory */
+  if (drawn)
+    sprite_cache_store(&key, sprite);
+}
+
+/* No more jobs per batch than atlas cells, so no bake evicts a queued icon */
+#define MAX_SPRITE_JOBS ICON_ATLAS_CELLS
+
+typedef struct {
+  const WindowInfo *win;
+  SpriteKey key;
+  CardArt art;
+  cairo_surface_t *sprite;
+} SpriteJob;
+
+static void sprite_job_run(void *arg, int index) {
+  SpriteJob *job = &((SpriteJob *)arg)[index];
+  job->sprite = draw_sprite(job->win, &job->art, &job->key);
+}
+
+/*
+ * Queue the missing sprites of cards first .. g->last - 1, up to a batch,
+ * draw them on the workers and store them. Returns the first card not
+ * looked at.
+ */
+static int draw_sprite_batch(AppState *state, const Grid *g, int first) {
+  SpriteJob jobs[MAX_SPRITE_JOBS];
+  int n = 0;
+  int i = first;
+  for (; i < g->last && n < MAX_SPRITE_JOBS; i++) {
+    double x, y;
+    card_origin(g, i, &x, &y);
+    SpriteJob *job = &jobs[n];
+    job->win = &state->windows[i];
+    sprite_key(job->win, i == state->selected_index, x, y, &job->key);
+    if (sprite_cache_lookup(&job->key))
+      continue;
+
+    /* Same title and class twice: one sprite serves both */
+    bool queued = false;
+    for (int j = 0; j < n && !queued; j++)
+      queued = sprite_key_equal(&jobs[j].key, &job->key);
+    if (queued)
+      continue;
+
+    card_art_get(job->win, &job->art);
+    job->sprite = NULL;
+    n++;
+  }
+
+  /* A single card is not worth waking the workers for */
+  if (n >= 2)
+    workers_run(sprite_job_run, jobs, n);
+
+  for (int j = 0; j < n; j++) {
+    if (jobs[j].sprite)
+      sprite_cache_store(&jobs[j].key, jobs[j].sprite);
+  }
+  return i;
+}
+
+/*
+ * Cards are independent tiles: draw every sprite the frame is missing on
+ * the worker threads, each into its own surface, then hand them to the
+ * cache before the frame is blitted together on the daemon thread. The
+ * cache was sized to the grid in view, so no batch evicts an earlier one.
+ */
+static void draw_missing_sprites(AppState *state, const Grid *g) {
+  if (workers_count() < 2)
+    return;
+
+  for (int i = g->first; i < g->last;)
+    i = draw_sprite_batch(state, g, i);
+}
+
+/*
+ * Redraw one rect of a frame exactly as a full redraw would: background,
+ * then every card reaching into it, in grid order.
+ */
+static void repaint_rect(cairo_t *cr, AppState *state, const Grid *g,
+                         const RenderRect *rc, uint32_t width,
+                         uint32_t height) {
+  cairo_save(cr);
+  cairo_rectangle(cr, rc->x, rc->y, rc->w, rc->h);
+  cairo_clip(cr);
+  paint_background(cr, width, height);
+
+  for (int i = g->first; i < g->last; i++) {
+    RenderRect ext = card_extent(g, i, width, height);
+    if (!rects_overlap(&ext, rc))
+      continue;
+    double x, y;
+    card_origin(g, i, &x, &y);
+    blit_card(cr, &state->windows[i], x, y, i == state->selected_index);
+  }
+  cairo_restore(cr);
+}
+
+/*
+ * Where the view sits in a grid taller than max_rows: a thin bar in the
+ * right padding, skipped when the padding has no room clear of the cards
+ * (selection redraws never repaint it).
+ */
+static void draw_scrollbar(cairo_t *cr, const AppState *state, const Grid *g,
+                           uint32_t width) {
+  if (g->view_rows >= g->rows)
+    return;
+
+  int cols = (state->count < g->max_cols) ? state->count : g->max_cols;
+  double grid_right = g->x + (cols * g->card_w) + ((cols - 1) * g->gap);
+  double bar_w = 4;
+  double bar_x = width - ((cfg ? cfg->padding : 32) + bar_w) / 2.0;
+  if (bar_x < grid_right + 6 + card_margin())
+    return;
+
+  double track = (g->view_rows * g->card_h) + ((g->view_rows - 1) * g->gap);
+  double thumb = track * g->view_rows / g->rows;
+  double top = g->y + track * state->first_row / g->rows;
+
+  double r = 0.5, gr = 0.5, b = 0.5;
+  if (cfg)
+    color_to_rgb(cfg->border_color, &r, &gr, &b);
+  cairo_set_source_rgba(cr, r, gr, b, 0.15);
+  draw_rounded_rect(cr, bar_x, g->y, bar_w, track, bar_w / 2);
+  cairo_fill(cr);
+  cairo_set_source_rgba(cr, r, gr, b, 0.6);
+  draw_rounded_rect(cr, bar_x, top, bar_w, thumb, bar_w / 2);
+  cairo_fill(cr);
+}
+
+/* Draw a whole frame, replacing whatever the target holds */
+static void draw_frame(cairo_t *cr, AppState *state, uint32_t width,
+                       uint32_t height) {
+  paint_background(cr, width, height);
 
   /* Content */
   if (!state || state->count == 0) {
-    PangoLayout *msg = create_layout(cr, 16);
-    pango_layout_set_text(msg, "No windows", -1);
+    double r = 0.1, g = 0.1, b = 0.2;
+    PangoLayout *msg = text_layout("No windows", MESSAGE_TEXT_SIZE, 0);
     int mw, mh;
     pango_layout_get_pixel_size(msg, &mw, &mh);
 
@@ -331,50 +1003,177 @@ void render_ui(AppState *state, uint32_t width, uint32_t height) {
     cairo_set_source_rgba(cr, r, g, b, 0.5);
     cairo_move_to(cr, (width - mw) / 2.0, (height - mh) / 2.0);
     pango_cairo_show_layout(cr, msg);
-    g_object_unref(msg);
-  } else {
-    int cw = cfg ? cfg->card_width : 200;
-    int ch = cfg ? cfg->card_height : 160;
-    int gap = cfg ? cfg->card_gap : 12;
-    int pad = cfg ? cfg->padding : 32;
-    int max_cols = cfg ? cfg->max_cols : 5;
-
-    int cols = (state->count < max_cols) ? state->count : max_cols;
-    int rows = (state->count + max_cols - 1) / max_cols;
-
-    int grid_w = (cols * cw) + ((cols - 1) * gap);
-    int grid_h = (rows * ch) + ((rows - 1) * gap);
-
-    double start_x = (width - grid_w) / 2.0;
-    double start_y = (height - grid_h) / 2.0;
-    if (start_x < pad)
-      start_x = pad;
-    if (start_y < pad)
-      start_y = pad;
-
-    for (int i = 0; i < state->count; i++) {
-      int r = i / max_cols;
-      int c = i % max_cols;
-      double x = start_x + c * (cw + gap);
-      double y = start_y + r * (ch + gap);
-      draw_card(cr, &state->windows[i], x, y, i == state->selected_index);
-    }
+    return;
   }
 
-  /* Wayland Commit */
-  struct wl_shm_pool *pool = wl_shm_create_pool(shm, fd, size);
-  struct wl_buffer *buffer = wl_shm_pool_create_buffer(
-      pool, 0, width, height, stride, WL_SHM_FORMAT_ARGB8888);
+  follow_selection(state);
+  Grid grid;
+  grid_layout(state, width, height, &grid);
+
+  /*
+   * Room for every card in view plus the other selection state of the two
+   * cards a Tab changes, so a full frame never evicts its own sprites
+   */
+  sprite_cache_reserve(grid.last - grid.first + 2);
+  draw_missing_sprites(state, &grid);
+
+  for (int i = grid.first; i < grid.last; i++) {
+    double x, y;
+    card_origin(&grid, i, &x, &y);
+    blit_card(cr, &state->windows[i], x, y, i == state->selected_index);
+  }
+  draw_scrollbar(cr, state, &grid, width);
+}
 
-  wl_surface_attach(surface, buffer, 0, 0);
-  wl_surface_damage_buffer(surface, 0, 0, width,
-                           height); /* Use damage_buffer for best safety */
-  wl_surface_commit(surface);
+bool render_prepare(AppState *state, uint32_t width, uint32_t height) {
+  render_discard();
+
+  ShmBuffer *buf = acquire_frame(width, height);
+  if (!buf)
+    return false;
+
+  cairo_surface_t *surf = cairo_image_surface_create_for_data(
+      buf->data, CAIRO_FORMAT_ARGB32, width, height, buf->stride);
+  cairo_t *cr = cairo_create(surf);
+  cairo_set_antialias(cr, CAIRO_ANTIALIAS_BEST);
+
+  /* Reused buffers still hold the previous frame */
+  draw_frame(cr, state, width, height);
 
   cairo_destroy(cr);
   cairo_surface_destroy(surf);
-  wl_buffer_destroy(buffer);
-  wl_shm_pool_destroy(pool);
-  close(fd);
-  munmap(data, size);
+  tag_frame(buf, state);
+
+  /* Keep it for render_present(), don't attach it yet */
+  prepared = buf;
+  return true;
+}
+
+bool render_present(uint32_t width, uint32_t height, bool keep) {
+  if (!prepared || prepared->width != width || prepared->height != height)
+    return false;
+
+  /* Wayland Commit */
+  attach_frame(prepared, NULL, 0);
+
+  if (keep) {
+    frame_release(&kept);
+    kept = prepared;
+    prepared = NULL;
+  } else {
+    render_discard();
+  }
+  return true;
+}
+
+bool render_kept_shows(const AppState *state, uint32_t width,
+                       uint32_t height) {
+  if (!kept || !state)
+    return false;
+  const FrameTag *tag = frame_tag(kept);
+  return frame_shows(tag, state, width, height) &&
+         tag->selected == state->selected_index;
+}
+
+bool render_present_kept(const AppState *state, uint32_t width,
+                         uint32_t height) {
+  if (!render_kept_shows(state, width, height))
+    return false;
+  attach_frame(kept, NULL, 0);
+  return true;
+}
+
+/*
+ * Selection change within the snapshot on screen: bring a buffer that
+ * already holds this snapshot (or a copy of the frame on screen) up to
+ * date by repainting the cards whose selection differs, and damage only
+ * the cards that differ from the frame on screen.
+ */
+static bool redraw_selection(AppState *state, uint32_t width,
+                             uint32_t height) {
+  if (!state || state->count == 0)
+    return false;
+
+  /* Scrolling moves every card; frame_shows() then asks for a full frame */
+  follow_selection(state);
+  if (!frame_shows(&shown, state, width, height) ||
+      shown.selected == state->selected_index)
+    return false;
+
+  render_discard();
+  ShmBuffer *buf = acquire_frame(width, height);
+  if (!buf)
+    return false;
+
+  FrameTag *tag = frame_tag(buf);
+  if (!frame_shows(tag, state, width, height)) {
+    /* The compositor only reads the buffer on screen; copy it */
+    FrameTag *src = frame_tag(shown.buf);
+    if (!frame_shows(src, state, width, height) ||
+        src->selected != shown.selected) {
+      sink->release(buf);
+      return false;
+    }
+    memcpy(buf->data, shown.buf->data, (size_t)buf->stride * height);
+    tag->content = src->content;
+    tag->thumbs = src->thumbs;
+    tag->windows = src->windows;
+    tag->count = src->count;
+    tag->selected = src->selected;
+    tag->first_row = src->first_row;
+    tag->width = src->width;
+    tag->height = src->height;
+  }
+
+  Grid grid;
+  grid_layout(state, width, height, &grid);
+  int sel = state->selected_index;
+
+  if (tag->selected != sel) {
+    cairo_surface_t *surf = cairo_image_surface_create_for_data(
+        buf->data, CAIRO_FORMAT_ARGB32, width, height, buf->stride);
+    cairo_t *cr = cairo_create(surf);
+    cairo_set_antialias(cr, CAIRO_ANTIALIAS_BEST);
+
+    RenderRect stale[2] = {card_extent(&grid, tag->selected, width, height),
+                           card_extent(&grid, sel, width, height)};
+    for (int i = 0; i < 2; i++)
+      repaint_rect(cr, state, &grid, &stale[i], width, height);
+
+    cairo_destroy(cr);
+    cairo_surface_destroy(surf);
+    tag->selected = sel;
+  }
+
+  RenderRect damage[2] = {card_extent(&grid, shown.selected, width, height),
+                          card_extent(&grid, sel, width, height)};
+  attach_frame(buf, damage, 2);
+  sink->release(buf);
+  return true;
+}
+
+void render_ui(AppState *state, uint32_t width, uint32_t height) {
+  /* Whatever was owed is drawn now */
+  dirty_state = NULL;
+  if (redraw_selection(state, width, height))
+    return;
+  if (render_prepare(state, width, height))
+    render_present(width, height, false);
+  else if (frame_callback)
+    dirty_state = state; /* Out of buffers; try again next frame */
+}
+
+void render_schedule(AppState *state) {
+  if (frame_callback) {
+    dirty_state = state;
+    return;
+  }
+  render_ui(state, state->width, state->height);
+}
+
+void render_cancel_frame(void) {
+  if (frame_callback)
+    wl_callback_destroy(frame_callback);
+  frame_callback = NULL;
+  dirty_state = NULL;
 }
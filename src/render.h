@@ -4,6 +4,8 @@
 
 #include "config.h"
 #include "data.h"
+#include "shm_pool.h"
+#include <stdbool.h>
 #include <stdint.h>
 #include <sys/types.h>
 #include <wayland-client.h>
@@ -12,16 +14,80 @@
 extern struct wl_shm *shm;
 extern struct wl_surface *surface;
 
+/* A rectangle of a frame, in buffer pixels */
+typedef struct {
+  int x, y, w, h;
+} RenderRect;
+
+/*
+ * Where finished frames go. By default they are attached to the layer
+ * surface from the shm pool; the headless sink (headless.h) keeps them in
+ * memory instead, so frames can be rendered and timed without a compositor.
+ */
+typedef struct {
+  /* A buffer of this size to draw into, NULL if none is free */
+  ShmBuffer *(*acquire)(uint32_t width, uint32_t height);
+  /* The renderer is done drawing into buf (it may still be shown) */
+  void (*release)(ShmBuffer *buf);
+  /* Show buf; only the damage rects changed, or all of it if n == 0 */
+  void (*present)(ShmBuffer *buf, const RenderRect *damage, int n);
+} RenderSink;
+
+/* Send frames to sink from now on; NULL goes back to the Wayland surface */
+void render_set_sink(const RenderSink *sink);
+
 /* Set config for rendering */
 void render_set_config(Config *config);
 
 /* Calculate optimal window dimensions based on window count */
 void calculate_dimensions(AppState *state, uint32_t *width, uint32_t *height);
 
-/* Render the window switcher UI */
+/*
+ * Render the window switcher UI. When only the selection moved since the
+ * frame on screen, just the two affected cards are repainted and damaged.
+ */
 void render_ui(AppState *state, uint32_t width, uint32_t height);
 
-/* Create a shared memory file for Wayland buffers */
-int create_shm_file(off_t size);
+/*
+ * Redraw state at its size once the compositor is ready for a new frame:
+ * at once if no frame is in flight, else from the frame callback. Calls in
+ * between only leave the latest state to draw.
+ */
+void render_schedule(AppState *state);
+
+/* Forget the frame in flight and any owed redraw (surface unmapped) */
+void render_cancel_frame(void);
+
+/* The snapshot changed; earlier frames can't be patched into new ones */
+void render_invalidate(void);
+
+/* Render a frame off-screen without attaching it to the surface */
+bool render_prepare(AppState *state, uint32_t width, uint32_t height);
+
+/*
+ * Attach and commit the prepared frame; false if none matches the size.
+ * With keep the frame is retained for render_present_kept() instead of
+ * being dropped (replacing any frame kept before).
+ */
+bool render_present(uint32_t width, uint32_t height, bool keep);
+
+/*
+ * The retained frame shows state exactly (same snapshot, previews,
+ * selection and scroll) at this size.
+ */
+bool render_kept_shows(const AppState *state, uint32_t width, uint32_t height);
+
+/* Attach and commit the retained frame again; false unless it shows state */
+bool render_present_kept(const AppState *state, uint32_t width,
+                         uint32_t height);
+
+/* Drop the prepared frame, if any */
+void render_discard(void);
+
+/* Drop the retained frame, if any */
+void render_discard_kept(void);
+
+/* Free cached card sprites and the panel background */
+void render_cleanup(void);
 
 #endif /* RENDER_H */
@@ -0,0 +1,157 @@
+/* src/shm_pool.c - Reusable shared memory buffers for the panel */
+#define _GNU_SOURCE /* memfd_create */
+
+#include "shm_pool.h"
+#include "render.h"
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#define LOG(fmt, ...) fprintf(stderr, "[ShmPool] " fmt "\n", ##__VA_ARGS__)
+#define SIZE_CLASS_MIN (64 * 1024)
+
+typedef struct {
+  ShmBuffer pub; /* First, so a ShmBuffer * is also a Slot * */
+  struct wl_shm_pool *pool;
+  size_t capacity; /* Bytes mapped, a power of two */
+  bool held;       /* Owned by the renderer */
+  bool busy;       /* Attached, not yet released by the compositor */
+} Slot;
+
+static Slot slots[SHM_POOL_BUFFERS];
+
+int create_shm_file(off_t size) {
+  int fd = memfd_create("snappy-switcher", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+  if (fd >= 0) {
+    if (ftruncate(fd, size) < 0) {
+      close(fd);
+      return -1;
+    }
+    /* The compositor maps this too; never let it shrink under them */
+    fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK);
+    return fd;
+  }
+
+  /* Kernels without memfd: an unlinked temporary file */
+  char name[] = "/tmp/snappy-shm-XXXXXX";
+  fd = mkstemp(name);
+  if (fd < 0)
+    return -1;
+  unlink(name);
+  if (ftruncate(fd, size) < 0) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+static void buffer_release(void *data, struct wl_buffer *buffer) {
+  (void)buffer;
+  ((Slot *)data)->busy = false;
+}
+
+static const struct wl_buffer_listener buffer_listener = {
+    .release = buffer_release,
+};
+
+static void slot_destroy_buffer(Slot *slot) {
+  if (slot->pub.buffer)
+    wl_buffer_destroy(slot->pub.buffer);
+  slot->pub.buffer = NULL;
+  slot->busy = false;
+}
+
+static void slot_unmap(Slot *slot) {
+  slot_destroy_buffer(slot);
+  if (slot->pool)
+    wl_shm_pool_destroy(slot->pool);
+  if (slot->pub.data)
+    munmap(slot->pub.data, slot->capacity);
+  memset(slot, 0, sizeof(*slot));
+}
+
+/* Map at least size bytes, rounded up to the size class */
+static int slot_map(Slot *slot, size_t size) {
+  size_t capacity = SIZE_CLASS_MIN;
+  while (capacity < size)
+    capacity *= 2;
+
+  int fd = create_shm_file(capacity);
+  if (fd < 0)
+    return -1;
+
+  void *data = mmap(NULL, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (data == MAP_FAILED) {
+    close(fd);
+    return -1;
+  }
+
+  slot->pool = wl_shm_create_pool(shm, fd, capacity);
+  close(fd);
+  slot->pub.data = data;
+  slot->capacity = capacity;
+  LOG("Mapped %zu KiB buffer", capacity / 1024);
+  return 0;
+}
+
+ShmBuffer *shm_pool_acquire(uint32_t width, uint32_t height) {
+  if (!shm || width == 0 || height == 0)
+    return NULL;
+
+  Slot *slot = NULL;
+  for (int i = 0; i < SHM_POOL_BUFFERS; i++) {
+    if (slots[i].held || slots[i].busy)
+      continue;
+    /* Prefer a buffer that already has this size */
+    if (!slot || (slots[i].pub.buffer && slots[i].pub.width == width &&
+                  slots[i].pub.height == height))
+      slot = &slots[i];
+  }
+  if (!slot)
+    return NULL;
+
+  uint32_t stride = width * 4;
+  size_t size = (size_t)stride * height;
+
+  if (size > slot->capacity) {
+    slot_unmap(slot);
+    if (slot_map(slot, size) < 0) {
+      slot_unmap(slot);
+      return NULL;
+    }
+  }
+
+  if (!slot->pub.buffer || slot->pub.width != width ||
+      slot->pub.height != height) {
+    slot_destroy_buffer(slot);
+    slot->pub.buffer = wl_shm_pool_create_buffer(
+        slot->pool, 0, width, height, stride, WL_SHM_FORMAT_ARGB8888);
+    if (!slot->pub.buffer)
+      return NULL;
+    wl_buffer_add_listener(slot->pub.buffer, &buffer_listener, slot);
+    slot->pub.width = width;
+    slot->pub.height = height;
+    slot->pub.stride = stride;
+  }
+
+  slot->held = true;
+  return &slot->pub;
+}
+
+void shm_pool_attached(ShmBuffer *buf) {
+  if (buf)
+    ((Slot *)buf)->busy = true;
+}
+
+void shm_pool_release(ShmBuffer *buf) {
+  if (buf)
+    ((Slot *)buf)->held = false;
+}
+
+void shm_pool_cleanup(void) {
+  for (int i = 0; i < SHM_POOL_BUFFERS; i++)
+    slot_unmap(&slots[i]);
+}
@@ -0,0 +1,43 @@
+/* src/shm_pool.h - Reusable shared memory buffers for the panel */
+#ifndef SHM_POOL_H
+#define SHM_POOL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include <wayland-client.h>
+
+/*
+ * A few ARGB8888 buffers that are reused from frame to frame. Each one has
+ * its own memfd, mapping and wl_shm_pool, sized in power-of-two classes,
+ * so a new frame only costs a new wl_buffer when the panel size changes
+ * and a new mapping when it outgrows its size class. A buffer is handed
+ * out only while the renderer does not hold it and the compositor has
+ * released it (wl_buffer.release).
+ */
+#define SHM_POOL_BUFFERS 3
+
+typedef struct {
+  struct wl_buffer *buffer;
+  void *data;
+  uint32_t width;
+  uint32_t height;
+  uint32_t stride;
+} ShmBuffer;
+
+/* Take a free buffer of this size, NULL if all are in use */
+ShmBuffer *shm_pool_acquire(uint32_t width, uint32_t height);
+
+/* Mark the buffer attached to a surface until the compositor releases it */
+void shm_pool_attached(ShmBuffer *buf);
+
+/* The renderer is done with the buffer (it may still be attached) */
+void shm_pool_release(ShmBuffer *buf);
+
+/* Destroy all buffers */
+void shm_pool_cleanup(void);
+
+/* Anonymous shared memory file of the given size (memfd when available) */
+int create_shm_file(off_t size);
+
+#endif /* SHM_POOL_H */
@@ -132,6 +132,42 @@ int send_command(const char *cmd) {
   return 0;
 }
 
+/* Client: Send command and read the daemon's reply */
+int send_command_reply(const char *cmd, char *reply, size_t size) {
+  int sock = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (sock < 0) {
+    LOG("Failed to create client socket: %s", strerror(errno));
+    return -1;
+  }
+
+  struct sockaddr_un addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  strncpy(addr.sun_path, SOCKET_PATH, sizeof(addr.sun_path) - 1);
+
+  if (connect(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+    LOG("Failed to connect to daemon: %s", strerror(errno));
+    close(sock);
+    return -1;
+  }
+
+  if (write(sock, cmd, strlen(cmd)) < 0) {
+    LOG("Failed to send command: %s", strerror(errno));
+    close(sock);
+    return -1;
+  }
+  shutdown(sock, SHUT_WR);
+
+  size_t total = 0;
+  ssize_t n;
+  while (total < size - 1 &&
+         (n = read(sock, reply + total, size - 1 - total)) > 0)
+    total += n;
+  reply[total] = '\0';
+  close(sock);
+  return 0;
+}
+
 /* Check if daemon is running */
 bool is_daemon_running(void) {
   int sock = socket(AF_UNIX, SOCK_STREAM, 0);
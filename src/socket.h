@@ -3,6 +3,7 @@
 #define SOCKET_H
 
 #include <stdbool.h>
+#include <stddef.h>
 
 /* Socket path */
 #define SOCKET_PATH "/tmp/snappy-switcher.sock"
@@ -14,6 +15,8 @@
 #define CMD_TOGGLE "TOGGLE"
 #define CMD_HIDE "HIDE"
 #define CMD_QUIT "QUIT"
+#define CMD_PREFETCH "PREFETCH"
+#define CMD_STATS "STATS"
 
 /* Server functions (daemon) */
 int init_server(void);
@@ -24,6 +27,9 @@ int get_server_fd(void);
 /* Client functions */
 int send_command(const char *cmd);
 
+/* Send a command and copy the daemon's reply into reply (NUL-terminated) */
+int send_command_reply(const char *cmd, char *reply, size_t size);
+
 /* Check if daemon is running */
 bool is_daemon_running(void);
 
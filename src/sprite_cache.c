@@ -0,0 +1,206 @@
+/* src/sprite_cache.c - Rasterized card images */
+#define _POSIX_C_SOURCE 200809L
+
+#include "sprite_cache.h"
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+  uint32_t hash;
+  char *title;
+  SpriteKey key; /* key.title points at title */
+  cairo_surface_t *sprite; /* NULL = empty */
+  int newer, older;        /* Recency list, -1 at either end */
+} SpriteSlot;
+
+/*
+ * Slots are found through an open-addressed table of slot numbers on the
+ * key hash (linear probing, -1 = free), at most half full. Every slot,
+ * empty or not, is on a list from most to least recently used, with the
+ * empty ones at the old end, so a store takes the oldest slot.
+ */
+static SpriteSlot *slots = NULL;
+static int capacity = 0;
+static int *table = NULL;
+static uint32_t table_mask = 0;
+static int newest = -1, oldest = -1;
+
+static uint32_t key_hash(const SpriteKey *key) {
+  uint32_t h = 2166136261u;
+  for (const char *p = key->title ? key->title : ""; *p; p++)
+    h = (h ^ (unsigned char)*p) * 16777619u;
+  h = (h ^ key->class_atom) * 16777619u;
+  h = (h ^ (uint32_t)key->group_count) * 16777619u;
+  h = (h ^ (uint32_t)key->preview) * 16777619u;
+  h = (h ^ (uint32_t)(key->phase_x * 64)) * 16777619u;
+  h = (h ^ (uint32_t)(key->phase_y * 64)) * 16777619u;
+  return h ^ (key->selected ? 0x80000000u : 0);
+}
+
+bool sprite_key_equal(const SpriteKey *a, const SpriteKey *b) {
+  return a->class_atom == b->class_atom && a->group_count == b->group_count &&
+         a->selected == b->selected && a->preview == b->preview &&
+         a->phase_x == b->phase_x && a->phase_y == b->phase_y &&
+         strcmp(a->title ? a->title : "", b->title ? b->title : "") == 0;
+}
+
+static void list_unlink(int i) {
+  SpriteSlot *slot = &slots[i];
+  if (slot->newer >= 0)
+    slots[slot->newer].older = slot->older;
+  else
+    newest = slot->older;
+  if (slot->older >= 0)
+    slots[slot->older].newer = slot->newer;
+  else
+    oldest = slot->newer;
+}
+
+static void list_push_newest(int i) {
+  slots[i].newer = -1;
+  slots[i].older = newest;
+  if (newest >= 0)
+    slots[newest].newer = i;
+  else
+    oldest = i;
+  newest = i;
+}
+
+static void list_push_oldest(int i) {
+  slots[i].older = -1;
+  slots[i].newer = oldest;
+  if (oldest >= 0)
+    slots[oldest].older = i;
+  else
+    newest = i;
+  oldest = i;
+}
+
+static void table_insert(int i) {
+  uint32_t pos = slots[i].hash & table_mask;
+  while (table[pos] >= 0)
+    pos = (pos + 1) & table_mask;
+  table[pos] = i;
+}
+
+/* Remove slot i, shifting back later entries of its probe run */
+static void table_remove(int i) {
+  uint32_t pos = slots[i].hash & table_mask;
+  while (table[pos] != i)
+    pos = (pos + 1) & table_mask;
+
+  for (uint32_t next = (pos + 1) & table_mask; table[next] >= 0;
+       next = (next + 1) & table_mask) {
+    uint32_t home = slots[table[next]].hash & table_mask;
+    /* Movable unless its home lies cyclically in (pos, next] */
+    if (((next - home) & table_mask) >= ((next - pos) & table_mask)) {
+      table[pos] = table[next];
+      pos = next;
+    }
+  }
+  table[pos] = -1;
+}
+
+static void slot_clear(int i) {
+  SpriteSlot *slot = &slots[i];
+  if (slot->sprite) {
+    table_remove(i);
+    cairo_surface_destroy(slot->sprite);
+  }
+  free(slot->title);
+  slot->title = NULL;
+  slot->sprite = NULL;
+}
+
+cairo_surface_t *sprite_cache_lookup(const SpriteKey *key) {
+  if (!table)
+    return NULL;
+  uint32_t hash = key_hash(key);
+  for (uint32_t pos = hash & table_mask; table[pos] >= 0;
+       pos = (pos + 1) & table_mask) {
+    int i = table[pos];
+    if (slots[i].hash == hash && sprite_key_equal(&slots[i].key, key)) {
+      list_unlink(i);
+      list_push_newest(i);
+      return slots[i].sprite;
+    }
+  }
+  return NULL;
+}
+
+bool sprite_cache_reserve(int count) {
+  if (count < SPRITE_CACHE_MIN)
+    count = SPRITE_CACHE_MIN;
+  if (count <= capacity)
+    return true;
+
+  uint32_t size = 16;
+  while (size < (uint32_t)count * 2)
+    size <<= 1;
+  int *grown_table = malloc(size * sizeof(int));
+  SpriteSlot *grown = realloc(slots, (size_t)count * sizeof(SpriteSlot));
+  if (!grown_table || !grown) {
+    free(grown_table);
+    if (grown)
+      slots = grown;
+    return false;
+  }
+  slots = grown;
+
+  /* New slots are empty, so they go to the old end */
+  for (int i = capacity; i < count; i++) {
+    memset(&slots[i], 0, sizeof(SpriteSlot));
+    list_push_oldest(i);
+  }
+
+  free(table);
+  table = grown_table;
+  table_mask = size - 1;
+  memset(table, -1, size * sizeof(int));
+  for (int i = 0; i < capacity; i++)
+    if (slots[i].sprite)
+      table_insert(i);
+  capacity = count;
+  return true;
+}
+
+void sprite_cache_store(const SpriteKey *key, cairo_surface_t *sprite) {
+  char *title = strdup(key->title ? key->title : "");
+  if (!title || !sprite_cache_reserve(SPRITE_CACHE_MIN)) {
+    free(title);
+    cairo_surface_destroy(sprite);
+    return;
+  }
+
+  /* Empty slot, else the least recently used one */
+  int i = oldest;
+  slot_clear(i);
+  list_unlink(i);
+  list_push_newest(i);
+
+  SpriteSlot *slot = &slots[i];
+  slot->hash = key_hash(key);
+  slot->title = title;
+  slot->key = *key;
+  slot->key.title = title;
+  slot->sprite = sprite;
+  table_insert(i);
+}
+
+void sprite_cache_clear(void) {
+  /* All slots end up empty, so their order no longer matters */
+  for (int i = 0; i < capacity; i++)
+    slot_clear(i);
+}
+
+void sprite_cache_cleanup(void) {
+  sprite_cache_clear();
+  free(slots);
+  free(table);
+  slots = NULL;
+  table = NULL;
+  table_mask = 0;
+  capacity = 0;
+  newest = -1;
+  oldest = -1;
+}
@@ -0,0 +1,46 @@
+/* src/sprite_cache.h - Rasterized card images */
+#ifndef SPRITE_CACHE_H
+#define SPRITE_CACHE_H
+
+#include "atoms.h"
+#include <cairo/cairo.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * A card is drawn once into its own ARGB32 surface and blitted on later
+ * frames. Everything the card's pixels depend on is in the key; a title
+ * change simply misses and the stale sprite ages out. Theme changes clear
+ * the whole cache. It holds SPRITE_CACHE_MIN sprites until the renderer
+ * grows it to fit a larger grid.
+ */
+#define SPRITE_CACHE_MIN 64
+
+typedef struct {
+  const char *title;
+  Atom class_atom;
+  int group_count;
+  bool selected;
+  uint64_t preview; /* The shown Thumbnail's generation, else 0 */
+  double phase_x;   /* Subpixel offset of the card origin */
+  double phase_y;
+} SpriteKey;
+
+bool sprite_key_equal(const SpriteKey *a, const SpriteKey *b);
+
+/* Cached sprite for key, NULL if none; valid until the next store */
+cairo_surface_t *sprite_cache_lookup(const SpriteKey *key);
+
+/* Keep sprite for key, evicting the least recently used (takes the ref) */
+void sprite_cache_store(const SpriteKey *key, cairo_surface_t *sprite);
+
+/* Make room for at least count sprites; false (size kept) if out of memory */
+bool sprite_cache_reserve(int count);
+
+/* Drop every sprite (theme or card geometry changed), keeping the room */
+void sprite_cache_clear(void);
+
+/* Drop every sprite and free the cache */
+void sprite_cache_cleanup(void);
+
+#endif /* SPRITE_CACHE_H */
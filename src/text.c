@@ -0,0 +1,187 @@
+/* src/text.c - Shared Pango context and shaped text layouts */
+#define _POSIX_C_SOURCE 200809L
+
+#include "text.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#define LOG(fmt, ...) fprintf(stderr, "[Text] " fmt "\n", ##__VA_ARGS__)
+#define MAX_FONTS 8
+
+typedef struct {
+  int size; /* 0 = empty */
+  PangoFontDescription *desc;
+} FontSlot;
+
+typedef struct {
+  uint32_t hash;
+  char *text;
+  int size;
+  int width;
+  PangoLayout *layout;
+  uint64_t stamp; /* Last store or lookup, 0 = empty */
+} LayoutSlot;
+
+/* Each hash maps to one set of TEXT_CACHE_WAYS slots */
+#define LAYOUT_SETS (TEXT_CACHE_SIZE / TEXT_CACHE_WAYS)
+
+/* The theme font, set on the daemon thread while no worker runs */
+static char font_family[64] = "Sans";
+static PangoWeight font_weight = PANGO_WEIGHT_BOLD;
+static unsigned font_serial = 1;
+
+/* Pango objects must not be shared between threads: one set per thread */
+static _Thread_local PangoContext *context = NULL;
+static _Thread_local FontSlot fonts[MAX_FONTS];
+static _Thread_local LayoutSlot layouts[TEXT_CACHE_SIZE];
+static _Thread_local uint64_t tick = 0;
+static _Thread_local unsigned font_seen = 0;
+
+static void clear_layouts(void) {
+  for (int i = 0; i < TEXT_CACHE_SIZE; i++) {
+    if (layouts[i].layout)
+      g_object_unref(layouts[i].layout);
+    free(layouts[i].text);
+    memset(&layouts[i], 0, sizeof(layouts[i]));
+  }
+  tick = 0;
+}
+
+static void clear_fonts(void) {
+  for (int i = 0; i < MAX_FONTS; i++) {
+    if (fonts[i].desc)
+      pango_font_description_free(fonts[i].desc);
+    memset(&fonts[i], 0, sizeof(fonts[i]));
+  }
+}
+
+/* Context with the font options of an image surface, as cairo draws on */
+static PangoContext *get_context(void) {
+  if (context)
+    return context;
+
+  context = pango_font_map_create_context(pango_cairo_font_map_get_default());
+  cairo_surface_t *scratch =
+      cairo_image_surface_create(CAIRO_FORMAT_ARGB32, 1, 1);
+  cairo_t *cr = cairo_create(scratch);
+  pango_cairo_update_context(cr, context);
+  cairo_destroy(cr);
+  cairo_surface_destroy(scratch);
+  return context;
+}
+
+/* Drop this thread's fonts and layouts if the theme font changed */
+static void sync_font(void) {
+  if (font_seen == font_serial)
+    return;
+  clear_layouts();
+  clear_fonts();
+  font_seen = font_serial;
+}
+
+static PangoFontDescription *get_font(int size) {
+  sync_font();
+  FontSlot *slot = NULL;
+  for (int i = 0; i < MAX_FONTS; i++) {
+    if (fonts[i].size == size)
+      return fonts[i].desc;
+    if (!slot && fonts[i].size == 0)
+      slot = &fonts[i];
+  }
+  /* More distinct sizes than slots: recycle the first */
+  if (!slot) {
+    slot = &fonts[0];
+    pango_font_description_free(slot->desc);
+  }
+
+  slot->desc = pango_font_description_new();
+  pango_font_description_set_family(slot->desc, font_family);
+  pango_font_description_set_weight(slot->desc, font_weight);
+  pango_font_description_set_size(slot->desc, size * PANGO_SCALE);
+  slot->size = size;
+  return slot->desc;
+}
+
+void text_set_font(const char *family, const char *weight, const int *sizes,
+                   int n_sizes) {
+  font_serial++;
+  snprintf(font_family, sizeof(font_family), "%s", family ? family : "Sans");
+  font_weight = (weight && strcasecmp(weight, "Normal") == 0)
+                    ? PANGO_WEIGHT_NORMAL
+                    : PANGO_WEIGHT_BOLD;
+
+  /* Load the fonts now so fontconfig is not consulted on the first show */
+  PangoContext *ctx = get_context();
+  for (int i = 0; i < n_sizes; i++) {
+    PangoFont *font = pango_context_load_font(ctx, get_font(sizes[i]));
+    if (font)
+      g_object_unref(font);
+    else
+      LOG("No font for \"%s\" at %d pt", font_family, sizes[i]);
+  }
+}
+
+static uint32_t layout_hash(const char *text, int size, int width) {
+  uint32_t h = 2166136261u;
+  for (const char *p = text; *p; p++)
+    h = (h ^ (unsigned char)*p) * 16777619u;
+  h = (h ^ (uint32_t)size) * 16777619u;
+  return (h ^ (uint32_t)width) * 16777619u;
+}
+
+PangoLayout *text_layout(const char *text, int size, int width) {
+  if (!text)
+    text = "";
+  if (width <= 0)
+    width = -1;
+
+  sync_font();
+  uint32_t hash = layout_hash(text, size, width);
+  LayoutSlot *set = &layouts[(hash % LAYOUT_SETS) * TEXT_CACHE_WAYS];
+  LayoutSlot *slot = &set[0];
+  for (int i = 0; i < TEXT_CACHE_WAYS; i++) {
+    LayoutSlot *s = &set[i];
+    if (s->stamp && s->hash == hash && s->size == size && s->width == width &&
+        strcmp(s->text, text) == 0) {
+      s->stamp = ++tick;
+      return s->layout;
+    }
+    /* Empty slot, else the least recently used one */
+    if (slot->stamp && s->stamp < slot->stamp)
+      slot = s;
+  }
+
+  PangoLayout *layout = pango_layout_new(get_context());
+  pango_layout_set_font_description(layout, get_font(size));
+  if (width > 0) {
+    pango_layout_set_width(layout, width * PANGO_SCALE);
+    pango_layout_set_ellipsize(layout, PANGO_ELLIPSIZE_END);
+    pango_layout_set_alignment(layout, PANGO_ALIGN_CENTER);
+  }
+  pango_layout_set_text(layout, text, -1);
+
+  char *copy = strdup(text);
+  if (slot->layout)
+    g_object_unref(slot->layout);
+  free(slot->text);
+  slot->hash = hash;
+  slot->text = copy;
+  slot->size = size;
+  slot->width = width;
+  slot->layout = layout;
+  /* Without a copy of the text it can't be matched, only handed out once */
+  slot->stamp = copy ? ++tick : 0;
+  return layout;
+}
+
+void text_cleanup(void) {
+  clear_layouts();
+  clear_fonts();
+  if (context)
+    g_object_unref(context);
+  context = NULL;
+}
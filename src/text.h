@@ -0,0 +1,35 @@
+/* src/text.h - Shared Pango context and shaped text layouts */
+#ifndef TEXT_H
+#define TEXT_H
+
+#include <pango/pangocairo.h>
+
+/*
+ * All text goes through one PangoContext and one font description per
+ * size, set up when the theme is loaded. Shaped layouts are cached by
+ * (text, size, width), so drawing the same title, letter or badge again
+ * does no font resolution or shaping. Each thread gets its own context and
+ * caches; text_set_font() is only called while no other thread draws.
+ */
+#define TEXT_CACHE_SIZE 128
+/* Layouts are found by hash among this many slots, not the whole cache */
+#define TEXT_CACHE_WAYS 8
+
+/*
+ * Use this font for all text and resolve it at each of the given sizes
+ * now rather than on the first frame. Drops cached layouts.
+ */
+void text_set_font(const char *family, const char *weight, const int *sizes,
+                   int n_sizes);
+
+/*
+ * Layout of text at size points. With width > 0 it is centred in width
+ * pixels and ellipsized at the end. Owned by the cache; valid until the
+ * next text_layout() call.
+ */
+PangoLayout *text_layout(const char *text, int size, int width);
+
+/* Free the calling thread's context, fonts and layouts */
+void text_cleanup(void);
+
+#endif /* TEXT_H */
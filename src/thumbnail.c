@@ -0,0 +1,200 @@
+/* src/thumbnail.c - Downscaled window previews */
+#include "thumbnail.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* Pixels per box edge; 16-bit lanes hold up to 256 * 255 */
+#define BOX_MAX 256
+
+typedef struct {
+  char address[32];
+  uint64_t stamp; /* Last store or lookup, 0 = empty */
+  Thumbnail thumb;
+  uint32_t *pixels; /* THUMB_MAX_WIDTH * THUMB_MAX_HEIGHT, kept for reuse */
+} ThumbSlot;
+
+static ThumbSlot slots[THUMB_CACHE_SIZE];
+static uint64_t tick = 0;
+static uint64_t generation = 0;
+
+/* --- Downscaling --- */
+
+/*
+ * The box filter works on all four channels at once: a pixel is spread into
+ * four 16-bit lanes of a uint64_t, so summing a row of a box is one add per
+ * pixel instead of four.
+ */
+static inline uint64_t unpack(uint32_t p) {
+  uint64_t v = p;
+  v = (v | (v << 16)) & 0x0000FFFF0000FFFFull;
+  v = (v | (v << 8)) & 0x00FF00FF00FF00FFull;
+  return v;
+}
+
+/* Divide each lane by n (recip = 65536 / n) and pack back to ARGB32 */
+static inline uint32_t average(uint64_t sum, uint32_t recip) {
+  uint32_t b = ((uint32_t)(sum & 0xFFFF) * recip + 0x8000) >> 16;
+  uint32_t g = ((uint32_t)((sum >> 16) & 0xFFFF) * recip + 0x8000) >> 16;
+  uint32_t r = ((uint32_t)((sum >> 32) & 0xFFFF) * recip + 0x8000) >> 16;
+  uint32_t a = ((uint32_t)(sum >> 48) * recip + 0x8000) >> 16;
+  return (a << 24) | (r << 16) | (g << 8) | b;
+}
+
+/* Box edges: box i covers [edge[i], edge[i + 1]), capped at BOX_MAX */
+static void box_edges(int src, int dst, int *start, int *len) {
+  for (int i = 0; i < dst; i++) {
+    int a = (int)((int64_t)i * src / dst);
+    int b = (int)((int64_t)(i + 1) * src / dst);
+    if (b <= a)
+      b = a + 1;
+    if (b - a > BOX_MAX)
+      b = a + BOX_MAX;
+    start[i] = a;
+    len[i] = b - a;
+  }
+}
+
+void thumb_fit(int sw, int sh, int *dw, int *dh) {
+  if (sw <= 0 || sh <= 0) {
+    *dw = *dh = 0;
+    return;
+  }
+
+  int w = sw, h = sh;
+  if (w > THUMB_MAX_WIDTH) {
+    h = (int)((int64_t)h * THUMB_MAX_WIDTH / w);
+    w = THUMB_MAX_WIDTH;
+  }
+  if (h > THUMB_MAX_HEIGHT) {
+    w = (int)((int64_t)w * THUMB_MAX_HEIGHT / h);
+    h = THUMB_MAX_HEIGHT;
+  }
+  *dw = w > 0 ? w : 1;
+  *dh = h > 0 ? h : 1;
+}
+
+void thumb_downscale(const void *src, int sw, int sh, int src_stride,
+                     bool y_invert, bool opaque, uint32_t *dst, int dw,
+                     int dh) {
+  int xs[THUMB_MAX_WIDTH], xn[THUMB_MAX_WIDTH];
+  uint32_t xr[THUMB_MAX_WIDTH];
+  uint64_t acc[THUMB_MAX_WIDTH];
+
+  if (dw > THUMB_MAX_WIDTH || dw > sw || dh > sh || dw <= 0 || dh <= 0)
+    return;
+
+  box_edges(sw, dw, xs, xn);
+  for (int x = 0; x < dw; x++)
+    xr[x] = 65536 / xn[x];
+
+  uint32_t alpha = opaque ? 0xFF000000u : 0;
+
+  for (int y = 0; y < dh; y++) {
+    int y0 = (int)((int64_t)y * sh / dh);
+    int y1 = (int)((int64_t)(y + 1) * sh / dh);
+    if (y1 <= y0)
+      y1 = y0 + 1;
+    if (y1 - y0 > BOX_MAX)
+      y1 = y0 + BOX_MAX;
+
+    memset(acc, 0, dw * sizeof(uint64_t));
+
+    for (int sy = y0; sy < y1; sy++) {
+      int row = y_invert ? sh - 1 - sy : sy;
+      const uint32_t *line =
+          (const uint32_t *)((const char *)src + (size_t)row * src_stride);
+
+      /* Horizontal box, averaged back to 8 bits so rows can be summed */
+      for (int x = 0; x < dw; x++) {
+        const uint32_t *p = line + xs[x];
+        uint64_t sum = 0;
+        for (int i = 0; i < xn[x]; i++)
+          sum += unpack(p[i] | alpha);
+        acc[x] += unpack(average(sum, xr[x]));
+      }
+    }
+
+    uint32_t yr = 65536 / (y1 - y0);
+    uint32_t *out = dst + (size_t)y * dw;
+    for (int x = 0; x < dw; x++)
+      out[x] = average(acc[x], yr);
+  }
+}
+
+/* --- Preview Cache --- */
+
+static ThumbSlot *find_slot(const char *address) {
+  for (int i = 0; i < THUMB_CACHE_SIZE; i++) {
+    if (slots[i].stamp && strcmp(slots[i].address, address) == 0)
+      return &slots[i];
+  }
+  return NULL;
+}
+
+int thumbs_store(const char *address, const void *src, int sw, int sh,
+                 int src_stride, bool y_invert, bool opaque) {
+  if (!address || strlen(address) >= sizeof(slots[0].address) || !src)
+    return -1;
+
+  int dw, dh;
+  thumb_fit(sw, sh, &dw, &dh);
+  if (dw == 0)
+    return -1;
+
+  ThumbSlot *slot = find_slot(address);
+  if (!slot) {
+    /* Empty slot, else the least recently used one */
+    slot = &slots[0];
+    for (int i = 0; i < THUMB_CACHE_SIZE && slot->stamp; i++) {
+      if (slots[i].stamp < slot->stamp)
+        slot = &slots[i];
+    }
+  }
+
+  if (!slot->pixels) {
+    slot->pixels =
+        malloc(THUMB_MAX_WIDTH * THUMB_MAX_HEIGHT * sizeof(uint32_t));
+    if (!slot->pixels)
+      return -1;
+  }
+
+  thumb_downscale(src, sw, sh, src_stride, y_invert, opaque, slot->pixels, dw,
+                  dh);
+
+  strcpy(slot->address, address);
+  slot->thumb.width = dw;
+  slot->thumb.height = dh;
+  slot->thumb.pixels = slot->pixels;
+  slot->thumb.generation = ++generation;
+  slot->stamp = ++tick;
+  return 0;
+}
+
+const Thumbnail *thumbs_lookup(const char *address) {
+  if (!address)
+    return NULL;
+  ThumbSlot *slot = find_slot(address);
+  if (!slot)
+    return NULL;
+  slot->stamp = ++tick;
+  return &slot->thumb;
+}
+
+void thumbs_forget(const char *address) {
+  ThumbSlot *slot = address ? find_slot(address) : NULL;
+  if (slot) {
+    slot->stamp = 0;
+    generation++;
+  }
+}
+
+void thumbs_cleanup(void) {
+  for (int i = 0; i < THUMB_CACHE_SIZE; i++) {
+    free(slots[i].pixels);
+    memset(&slots[i], 0, sizeof(slots[i]));
+  }
+  tick = 0;
+  generation++;
+}
+
+uint64_t thumbs_generation(void) { return generation; }
@@ -0,0 +1,54 @@
+/* src/thumbnail.h - Downscaled window previews */
+#ifndef THUMBNAIL_H
+#define THUMBNAIL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Previews are fitted inside THUMB_MAX_WIDTH x THUMB_MAX_HEIGHT, keeping the
+ * window's aspect ratio, and are never upscaled.
+ */
+#define THUMB_MAX_WIDTH 256
+#define THUMB_MAX_HEIGHT 160
+
+/* Number of windows whose previews are kept (least recently stored drop) */
+#define THUMB_CACHE_SIZE 32
+
+/* A cached preview: premultiplied ARGB32, stride = width * 4 */
+typedef struct {
+  int width;
+  int height;
+  const uint32_t *pixels;
+  uint64_t generation; /* thumbs_generation() it was stored at, never reused */
+} Thumbnail;
+
+/* Size of the preview for a sw x sh source */
+void thumb_fit(int sw, int sh, int *dw, int *dh);
+
+/*
+ * Box-filter src (sw x sh ARGB32, src_stride bytes per row) down to dw x dh.
+ * y_invert reads the source bottom-up; opaque forces alpha to 0xff (for
+ * XRGB sources). Requires dw <= sw and dh <= sh.
+ */
+void thumb_downscale(const void *src, int sw, int sh, int src_stride,
+                     bool y_invert, bool opaque, uint32_t *dst, int dw,
+                     int dh);
+
+/* Downscale a captured frame into the preview for address, -1 on failure */
+int thumbs_store(const char *address, const void *src, int sw, int sh,
+                 int src_stride, bool y_invert, bool opaque);
+
+/* Cached preview for address, NULL if none; valid until the next store */
+const Thumbnail *thumbs_lookup(const char *address);
+
+/* Drop the preview for address (window closed) */
+void thumbs_forget(const char *address);
+
+/* Free all previews */
+void thumbs_cleanup(void);
+
+/* Changes whenever a preview is stored or dropped */
+uint64_t thumbs_generation(void);
+
+#endif /* THUMBNAIL_H */
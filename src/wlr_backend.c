@@ -5,8 +5,7 @@
 #include "backend.h"
 #include "config.h"
 #include "data.h"
-#include <errno.h>
-#include <poll.h>
+#include "mru_state.h"
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -19,91 +18,250 @@
 
 #define LOG(fmt, ...) fprintf(stderr, "[WLR] " fmt "\n", ##__VA_ARGS__)
 
+#define IDENTIFIER_PREFIX "wlr-"
+#define IDENTIFIER_SIZE 16
+#define INDEX_INITIAL_SIZE 64
+#define MAX_OUTPUTS 32 /* One bit each in WindowNode.outputs */
+
 typedef struct WindowNode WindowNode;
 
+/*
+ * Windows live on an intrusive doubly linked list in MRU order (head = most
+ * recently activated), in three segments:
+ *   hot  - activated this session, most recent first
+ *   warm - not yet activated, but found in the MRU history kept by an
+ *          earlier daemon (mru_state.c); ordered by that history
+ *   cold - never seen activated, newest first
+ * so a restarted daemon lists windows in the order the user left them.
+ * Each node is also chained into a hash index keyed by its numeric id,
+ * which is what the "wlr-<id>" identifier encodes.
+ */
 struct WindowNode {
   struct zwlr_foreign_toplevel_handle_v1 *handle;
   char *title;
   char *app_id;
-  char *identifier;
+  Atom app_atom; /* Interned app_id */
+  uint32_t id;
+  char identifier[IDENTIFIER_SIZE];
   int state;
   int is_active;
   int is_minimized;
-  uint64_t activation_serial; /* window activation serial */
+  int activated;    /* Focused this session (hot segment) */
+  uint64_t stamp;   /* MRU history stamp while warm, 0 = not restored */
+  uint32_t outputs; /* Bit i set while on outputs[i] */
+  WindowNode *prev;
   WindowNode *next;
+  WindowNode *index_next; /* Hash bucket chain */
 };
 
+/* wl_output bound for output_enter/leave, with its registry name */
+typedef struct {
+  struct wl_output *output;
+  uint32_t name;
+} OutputSlot;
+
 typedef struct {
-  struct wl_display *display;
-  struct wl_registry *registry;
   struct zwlr_foreign_toplevel_manager_v1 *manager;
-  struct wl_seat *seat;
-  WindowNode *windows;
+  OutputSlot outputs[MAX_OUTPUTS];
+  WindowNode *head;      /* Most recently activated */
+  WindowNode *tail;      /* Least recent */
+  WindowNode *warm_head; /* First restored window, NULL if none */
+  WindowNode *cold_head; /* First never-activated window, NULL if none */
+  WindowNode **index;    /* id -> node, size is a power of two */
+  uint32_t index_size;
+  uint32_t next_id;
   int window_count;
   int initialized;
-  int needs_refresh;
-  uint64_t activation_counter; /* global activation counter */
+  uint64_t generation; /* Bumped whenever the listed windows may change */
 } WlrBackendState;
 
 static WlrBackendState backend_state = {0};
 
+/* --- MRU List --- */
+static void list_unlink(WindowNode *window) {
+  if (backend_state.cold_head == window)
+    backend_state.cold_head = window->next;
+  if (backend_state.warm_head == window)
+    backend_state.warm_head =
+        window->next != backend_state.cold_head ? window->next : NULL;
+  if (window->prev)
+    window->prev->next = window->next;
+  else
+    backend_state.head = window->next;
+  if (window->next)
+    window->next->prev = window->prev;
+  else
+    backend_state.tail = window->prev;
+  window->prev = window->next = NULL;
+}
+
+static void list_insert_before(WindowNode *window, WindowNode *pos) {
+  window->next = pos;
+  window->prev = pos ? pos->prev : backend_state.tail;
+  if (window->prev)
+    window->prev->next = window;
+  else
+    backend_state.head = window;
+  if (pos)
+    pos->prev = window;
+  else
+    backend_state.tail = window;
+}
+
 // move window to the front of the activation history list
 static void move_window_to_front(WindowNode *window) {
-  if (!window || !backend_state.windows || window == backend_state.windows) {
+  if (!window)
     return;
+  if (window != backend_state.head || !window->activated) {
+    list_unlink(window);
+    list_insert_before(window, backend_state.head);
   }
+  window->activated = 1;
+  window->stamp = 0;
+  backend_state.generation++;
+  mru_state_touch(mru_state_fingerprint(window->app_id, window->title));
+}
 
-  // remove window from the list
-  WindowNode **prev = &backend_state.windows;
-  WindowNode *curr = backend_state.windows;
+// place a not yet activated window by its stamp from an earlier session
+static void restore_window(WindowNode *window, uint64_t stamp) {
+  list_unlink(window);
+  window->stamp = stamp;
 
-  while (curr) {
-    if (curr == window) {
-      *prev = curr->next;
+  WindowNode *pos = backend_state.warm_head ? backend_state.warm_head
+                                            : backend_state.cold_head;
+  while (pos && pos != backend_state.cold_head && pos->stamp > stamp)
+    pos = pos->next;
+
+  list_insert_before(window, pos);
+  if (!backend_state.warm_head || pos == backend_state.warm_head)
+    backend_state.warm_head = window;
+}
+
+/* --- Identifier Index --- */
+static uint32_t index_slot(uint32_t id, uint32_t size) {
+  return (id * 0x9E3779B1u) & (size - 1);
+}
+
+static int index_grow(void) {
+  uint32_t size = backend_state.index_size ? backend_state.index_size * 2
+                                           : INDEX_INITIAL_SIZE;
+  WindowNode **index = calloc(size, sizeof(WindowNode *));
+  if (!index)
+    return -1;
+
+  for (uint32_t i = 0; i < backend_state.index_size; i++) {
+    WindowNode *node = backend_state.index[i];
+    while (node) {
+      WindowNode *next = node->index_next;
+      uint32_t slot = index_slot(node->id, size);
+      node->index_next = index[slot];
+      index[slot] = node;
+      node = next;
+    }
+  }
+
+  free(backend_state.index);
+  backend_state.index = index;
+  backend_state.index_size = size;
+  return 0;
+}
+
+static int index_insert(WindowNode *window) {
+  if ((uint32_t)backend_state.window_count >= backend_state.index_size &&
+      index_grow() < 0)
+    return -1;
+  uint32_t slot = index_slot(window->id, backend_state.index_size);
+  window->index_next = backend_state.index[slot];
+  backend_state.index[slot] = window;
+  return 0;
+}
+
+static void index_remove(WindowNode *window) {
+  if (!backend_state.index)
+    return;
+  WindowNode **link =
+      &backend_state.index[index_slot(window->id, backend_state.index_size)];
+  while (*link) {
+    if (*link == window) {
+      *link = window->index_next;
       break;
     }
-    prev = &curr->next;
-    curr = curr->next;
+    link = &(*link)->index_next;
   }
+  window->index_next = NULL;
+}
 
-  // insert window to the front of the list
-  window->next = backend_state.windows;
-  backend_state.windows = window;
+/* Resolve a "wlr-<id>" identifier to its window */
+static WindowNode *index_lookup(const char *identifier) {
+  size_t prefix = strlen(IDENTIFIER_PREFIX);
+  if (!backend_state.index || strncmp(identifier, IDENTIFIER_PREFIX, prefix))
+    return NULL;
+
+  char *end;
+  unsigned long id = strtoul(identifier + prefix, &end, 10);
+  if (end == identifier + prefix || *end != '\0' || id > UINT32_MAX)
+    return NULL;
+
+  WindowNode *node =
+      backend_state.index[index_slot(id, backend_state.index_size)];
+  while (node && node->id != id)
+    node = node->index_next;
+  return node;
+}
 
-  // update activation serial (smaller numbers mean more recently activated)
-  backend_state.activation_counter++;
-  window->activation_serial = backend_state.activation_counter;
+/* --- Outputs --- */
+static uint32_t output_bit(struct wl_output *output) {
+  for (int i = 0; i < MAX_OUTPUTS; i++) {
+    if (output && backend_state.outputs[i].output == output)
+      return 1u << i;
+  }
+  return 0;
 }
 
-static void registry_handle_global(void *data, struct wl_registry *registry,
-                                   uint32_t name, const char *interface,
-                                   uint32_t version) {
-  (void)data;
-  LOG("Registry global: %s (name: %u, version: %u)", interface, name, version);
-
-  if (strcmp(interface, zwlr_foreign_toplevel_manager_v1_interface.name) == 0) {
-    backend_state.manager = wl_registry_bind(
-        registry, name, &zwlr_foreign_toplevel_manager_v1_interface, 1);
-    LOG("Bound foreign toplevel manager");
-  } else if (strcmp(interface, wl_seat_interface.name) == 0) {
-    backend_state.seat =
-        wl_registry_bind(registry, name, &wl_seat_interface, 1);
-    LOG("Bound seat");
+/*
+ * Output the user is on: the one showing the active window, else the most
+ * recently activated window that is on any output. 0 if unknown.
+ */
+static uint32_t focused_output_bit(void) {
+  WindowNode *fallback = NULL;
+  for (WindowNode *curr = backend_state.head; curr; curr = curr->next) {
+    if (!curr->outputs)
+      continue;
+    if (curr->is_active) {
+      fallback = curr;
+      break;
+    }
+    if (!fallback)
+      fallback = curr;
   }
+  if (!fallback)
+    return 0;
+  return fallback->outputs & -fallback->outputs; /* Lowest set bit */
 }
 
-static void registry_handle_global_remove(void *data,
-                                          struct wl_registry *registry,
-                                          uint32_t name) {
-  (void)data;
-  (void)registry;
-  LOG("Registry global remove: %u", name);
+static void output_remove(uint32_t name) {
+  for (int i = 0; i < MAX_OUTPUTS; i++) {
+    OutputSlot *slot = &backend_state.outputs[i];
+    if (!slot->output || slot->name != name)
+      continue;
+    for (WindowNode *curr = backend_state.head; curr; curr = curr->next)
+      curr->outputs &= ~(1u << i);
+    wl_output_destroy(slot->output);
+    slot->output = NULL;
+    backend_state.generation++;
+    LOG("Output %u removed", name);
+    return;
+  }
 }
 
-static const struct wl_registry_listener registry_listener = {
-    .global = registry_handle_global,
-    .global_remove = registry_handle_global_remove,
-};
+static void window_free(WindowNode *window) {
+  if (window->handle) {
+    zwlr_foreign_toplevel_handle_v1_destroy(window->handle);
+  }
+  free(window->title);
+  free(window->app_id);
+  free(window);
+}
 
 static void
 toplevel_handle_title(void *data,
@@ -114,7 +272,7 @@ toplevel_handle_title(void *data,
 
   if (window->title)
     free(window->title);
-  window->title = strdup(title ? title : "");
+  window->title = heap_strdup(title);
   LOG("Window title updated: %s", window->title);
 }
 
@@ -127,7 +285,8 @@ toplevel_handle_app_id(void *data,
 
   if (window->app_id)
     free(window->app_id);
-  window->app_id = strdup(app_id ? app_id : "");
+  window->app_id = heap_strdup(app_id);
+  window->app_atom = atom_intern(window->app_id);
   LOG("Window app_id updated: %s", window->app_id);
 }
 
@@ -135,20 +294,20 @@ static void
 toplevel_handle_output_enter(void *data,
                              struct zwlr_foreign_toplevel_handle_v1 *toplevel,
                              struct wl_output *output) {
-  (void)data;
+  WindowNode *window = (WindowNode *)data;
   (void)toplevel;
-  (void)output;
-  LOG("Window entered output");
+  window->outputs |= output_bit(output);
+  LOG("Window entered output: %s", window->title);
 }
 
 static void
 toplevel_handle_output_leave(void *data,
                              struct zwlr_foreign_toplevel_handle_v1 *toplevel,
                              struct wl_output *output) {
-  (void)data;
+  WindowNode *window = (WindowNode *)data;
   (void)toplevel;
-  (void)output;
-  LOG("Window left output");
+  window->outputs &= ~output_bit(output);
+  LOG("Window left output: %s", window->title);
 }
 
 static void
@@ -189,7 +348,20 @@ toplevel_handle_done(void *data,
   (void)toplevel;
 
   LOG("Window done: %s (app_id: %s)", window->title, window->app_id);
-  backend_state.needs_refresh = 1;
+
+  // keep the history current as the focused window's title changes, and
+  // look up windows we have not seen focused yet
+  uint64_t fingerprint = mru_state_fingerprint(window->app_id, window->title);
+  if (window->is_active) {
+    mru_state_touch(fingerprint);
+  } else if (!window->activated && !window->stamp) {
+    uint64_t stamp = mru_state_lookup(fingerprint);
+    if (stamp)
+      restore_window(window, stamp);
+  }
+
+  // title, app_id, state and output changes all end with done
+  backend_state.generation++;
 }
 
 static void
@@ -200,28 +372,12 @@ toplevel_handle_closed(void *data,
 
   LOG("Window closed: %s", window->title);
 
-  WindowNode **prev = &backend_state.windows;
-  WindowNode *curr = backend_state.windows;
-
-  while (curr) {
-    if (curr == window) {
-      *prev = curr->next;
-      backend_state.window_count--;
-      break;
-    }
-    prev = &curr->next;
-    curr = curr->next;
-  }
-
-  if (window->handle) {
-    zwlr_foreign_toplevel_handle_v1_destroy(window->handle);
-  }
-  free(window->title);
-  free(window->app_id);
-  free(window->identifier);
-  free(window);
+  list_unlink(window);
+  index_remove(window);
+  backend_state.window_count--;
+  window_free(window);
 
-  backend_state.needs_refresh = 1;
+  backend_state.generation++;
 }
 
 static void
@@ -263,16 +419,20 @@ manager_handle_toplevel(void *data,
 
   memset(window, 0, sizeof(WindowNode));
   window->handle = toplevel;
-  window->identifier = malloc(64);
-  if (window->identifier) {
-    snprintf(window->identifier, 64, "wlr-%p", toplevel);
+  window->id = ++backend_state.next_id;
+  snprintf(window->identifier, sizeof(window->identifier),
+           IDENTIFIER_PREFIX "%u", window->id);
+
+  if (index_insert(window) < 0) {
+    LOG("Failed to index window");
+    zwlr_foreign_toplevel_handle_v1_destroy(toplevel);
+    free(window);
+    return;
   }
 
-  // initial activation serial is 0 (0 means never activated)
-  window->activation_serial = 0;
-
-  window->next = backend_state.windows;
-  backend_state.windows = window;
+  // never-activated windows list after focused ones, newest first
+  list_insert_before(window, backend_state.cold_head);
+  backend_state.cold_head = window;
   backend_state.window_count++;
 
   zwlr_foreign_toplevel_handle_v1_add_listener(toplevel, &toplevel_listener,
@@ -298,21 +458,20 @@ static const struct zwlr_foreign_toplevel_manager_v1_listener manager_listener =
 };
 
 static void cleanup_windows(void) {
-  WindowNode *curr = backend_state.windows;
+  WindowNode *curr = backend_state.head;
   while (curr) {
     WindowNode *next = curr->next;
-    if (curr->handle) {
-      zwlr_foreign_toplevel_handle_v1_destroy(curr->handle);
-    }
-    free(curr->title);
-    free(curr->app_id);
-    free(curr->identifier);
-    free(curr);
+    window_free(curr);
     curr = next;
   }
-  backend_state.windows = NULL;
+  backend_state.head = NULL;
+  backend_state.tail = NULL;
+  backend_state.warm_head = NULL;
+  backend_state.cold_head = NULL;
+  free(backend_state.index);
+  backend_state.index = NULL;
+  backend_state.index_size = 0;
   backend_state.window_count = 0;
-  backend_state.activation_counter = 0;
 }
 
 int wlr_backend_init(void) {
@@ -321,64 +480,50 @@ int wlr_backend_init(void) {
     return 0;
   }
 
-  LOG("Initializing WLR backend...");
-
-  backend_state.display = wl_display_connect(NULL);
-  if (!backend_state.display) {
-    LOG("Failed to connect to Wayland display");
-    return -1;
-  }
-
-  backend_state.registry = wl_display_get_registry(backend_state.display);
-  if (!backend_state.registry) {
-    LOG("Failed to get registry");
-    wl_display_disconnect(backend_state.display);
-    return -1;
-  }
-
-  wl_registry_add_listener(backend_state.registry, &registry_listener, NULL);
-
-  LOG("First roundtrip to get globals...");
-  wl_display_roundtrip(backend_state.display);
+  /* The manager is bound on the daemon's own display once it connects;
+   * its events are then dispatched by the daemon's main loop */
+  LOG("Initializing WLR backend, waiting for the toplevel manager...");
+  mru_state_open();
+  backend_state.generation = 1;
+  return 0;
+}
 
-  if (!backend_state.manager) {
-    LOG("No foreign toplevel manager found");
-    wl_registry_destroy(backend_state.registry);
-    wl_display_disconnect(backend_state.display);
-    return -1;
+void wlr_backend_bind_global(struct wl_registry *registry, uint32_t name,
+                             const char *interface, uint32_t version) {
+  (void)version;
+
+  // outputs are only needed to tell which screen each window is on
+  if (strcmp(interface, wl_output_interface.name) == 0) {
+    for (int i = 0; i < MAX_OUTPUTS; i++) {
+      OutputSlot *slot = &backend_state.outputs[i];
+      if (slot->output)
+        continue;
+      slot->output = wl_registry_bind(registry, name, &wl_output_interface, 1);
+      slot->name = name;
+      LOG("Bound output %u", name);
+      return;
+    }
+    LOG("Too many outputs, ignoring output %u", name);
+    return;
   }
 
-  if (!backend_state.seat) {
-    LOG("Warning: No seat found, window activation may not work");
-  }
+  if (strcmp(interface, zwlr_foreign_toplevel_manager_v1_interface.name) !=
+          0 ||
+      backend_state.manager)
+    return;
 
+  backend_state.manager = wl_registry_bind(
+      registry, name, &zwlr_foreign_toplevel_manager_v1_interface, 1);
+  if (!backend_state.manager)
+    return;
   zwlr_foreign_toplevel_manager_v1_add_listener(backend_state.manager,
                                                 &manager_listener, NULL);
-
-  LOG("Second roundtrip to get initial windows...");
-  wl_display_roundtrip(backend_state.display);
-
-  // set activation serial for initial windows
-  int counter = 0;
-  WindowNode *curr = backend_state.windows;
-  while (curr) {
-    if (curr->is_active) {
-      // current active window should be in front
-      backend_state.activation_counter++;
-      curr->activation_serial = backend_state.activation_counter;
-      counter++;
-    }
-    curr = curr->next;
-  }
-
-  LOG("WLR backend initialized with %d windows (%d active)",
-      backend_state.window_count, counter);
   backend_state.initialized = 1;
-  backend_state.needs_refresh = 0;
-
-  return 0;
+  LOG("Bound foreign toplevel manager");
 }
 
+void wlr_backend_remove_global(uint32_t name) { output_remove(name); }
+
 void wlr_backend_cleanup(void) {
   LOG("Cleaning up WLR backend");
 
@@ -387,59 +532,31 @@ void wlr_backend_cleanup(void) {
     backend_state.manager = NULL;
   }
 
-  if (backend_state.seat) {
-    wl_seat_destroy(backend_state.seat);
-    backend_state.seat = NULL;
-  }
-
   cleanup_windows();
 
-  if (backend_state.registry) {
-    wl_registry_destroy(backend_state.registry);
-    backend_state.registry = NULL;
+  for (int i = 0; i < MAX_OUTPUTS; i++) {
+    if (backend_state.outputs[i].output)
+      wl_output_destroy(backend_state.outputs[i].output);
+    backend_state.outputs[i].output = NULL;
   }
 
-  if (backend_state.display) {
-    wl_display_disconnect(backend_state.display);
-    backend_state.display = NULL;
-  }
+  mru_state_close();
 
   backend_state.initialized = 0;
   backend_state.window_count = 0;
-  backend_state.needs_refresh = 0;
-  backend_state.activation_counter = 0;
+  backend_state.generation = 0;
 }
 
-int wlr_get_windows(AppState *state, Config *config) {
-  (void)config;
+uint64_t wlr_get_generation(void) { return backend_state.generation; }
 
+int wlr_get_windows(AppState *state, Config *config) {
   if (!backend_state.initialized) {
-    LOG("Backend not initialized");
+    LOG("No foreign toplevel manager bound");
     return -1;
   }
 
-  LOG("Getting windows from WLR backend...");
-
-  app_state_free(state);
-  app_state_init(state);
-
-  // process pending events
-  while (wl_display_prepare_read(backend_state.display) != 0) {
-    wl_display_dispatch_pending(backend_state.display);
-  }
-  wl_display_flush(backend_state.display);
-
-  struct pollfd pfd = {.fd = wl_display_get_fd(backend_state.display),
-                       .events = POLLIN};
-
-  if (poll(&pfd, 1, 0) > 0 && (pfd.revents & POLLIN)) {
-    wl_display_read_events(backend_state.display);
-  } else {
-    wl_display_cancel_read(backend_state.display);
-  }
-
-  wl_display_dispatch_pending(backend_state.display);
-
+  // toplevel events are dispatched continuously by the daemon's loop, so
+  // the list is already current
   LOG("Found %d windows via WLR protocol", backend_state.window_count);
 
   if (backend_state.window_count == 0) {
@@ -447,68 +564,46 @@ int wlr_get_windows(AppState *state, Config *config) {
     return 0;
   }
 
-  // sort windows by activation order
-  // the list is already sorted by activation order (most recently activated
-  // first)
-  WindowNode *curr = backend_state.windows;
-  int index = 0;
+  if (app_state_reserve(state, backend_state.window_count) < 0)
+    return -1;
 
-  while (curr) {
-    WindowInfo info;
+  // with follow_monitor only the focused output's windows are listed;
+  // windows not known to be on any output are kept rather than lost
+  uint32_t output = 0;
+  if (config && config->follow_monitor) {
+    output = focused_output_bit();
+    LOG("Listing windows on output bit 0x%x", output);
+  }
 
-    if (curr->is_minimized) {
-      curr = curr->next;
+  // the list is already in activation order (most recently activated first),
+  // and so is every per-output subset of it
+  for (WindowNode *curr = backend_state.head; curr; curr = curr->next) {
+    if (curr->is_minimized)
+      continue;
+    if (output && curr->outputs && !(curr->outputs & output))
       continue;
-    }
 
-    info.address = strdup(curr->identifier ? curr->identifier : "");
-    info.title = strdup(curr->title ? curr->title : "Untitled");
-    info.class_name = strdup(curr->app_id ? curr->app_id : "unknown");
+    WindowInfo info;
+    info.address = app_state_strdup(state, curr->identifier);
+    info.title =
+        app_state_strdup(state, curr->title ? curr->title : "Untitled");
+    info.class_name =
+        app_state_strdup(state, curr->app_id ? curr->app_id : "unknown");
+    info.class_atom = curr->app_id ? curr->app_atom : atom_intern("unknown");
     info.workspace_id = 0;
-
-    // use activation serial as focus_history_id
-    // activation serial is larger for more recently activated
-    // for windows that have never been activated, give them a very large value
-    // to ensure they are at the end
-    if (curr->activation_serial == 0) {
-      info.focus_history_id = 10000 + index;
-    } else {
-      // activation serial is smaller for more recently activated (because we
-      // want the most recently activated at the front) use the maximum value
-      // minus the serial number to achieve this
-      info.focus_history_id = 1000 - curr->activation_serial;
-    }
-
+    info.focus_history_id = state->count;
     info.is_active = curr->is_active;
     info.is_floating = 0;
     info.group_count = 1;
-    info.focus_history_id = curr->is_active ? 0 : info.focus_history_id;
+    info.first_member = state->count;
 
     if (app_state_add(state, &info) < 0) {
-      window_info_free(&info);
+      if (!state->arena_backed)
+        window_info_free(&info);
       LOG("Failed to add window to AppState");
     } else {
-      LOG("Added window %d: %s (%s), activation_serial: %lu", index, info.title,
-          info.class_name, (unsigned long)curr->activation_serial);
-    }
-
-    curr = curr->next;
-    index++;
-  }
-
-  // sort windows by focus_history_id (smaller numbers mean more recently
-  // activated)
-  if (state->count > 1) {
-    int i, j;
-    for (i = 0; i < state->count - 1; i++) {
-      for (j = i + 1; j < state->count; j++) {
-        if (state->windows[i].focus_history_id >
-            state->windows[j].focus_history_id) {
-          WindowInfo tmp = state->windows[i];
-          state->windows[i] = state->windows[j];
-          state->windows[j] = tmp;
-        }
-      }
+      LOG("Added window %d: %s (%s)", info.focus_history_id, info.title,
+          info.class_name);
     }
   }
 
@@ -524,28 +619,26 @@ void wlr_activate_window(const char *identifier) {
 
   LOG("Activating window: %s", identifier);
 
-  WindowNode *curr = backend_state.windows;
-  while (curr) {
-    if (curr->identifier && strcmp(curr->identifier, identifier) == 0) {
-      LOG("Found window to activate: %s", curr->title);
-
-      // update activation history: move window to the front
-      move_window_to_front(curr);
-
-      // send activation request
-      if (curr->handle && backend_state.seat) {
-        LOG("Activating window via WLR protocol: %s", curr->title);
-        zwlr_foreign_toplevel_handle_v1_activate(curr->handle,
-                                                 backend_state.seat);
-        wl_display_flush(backend_state.display);
-        LOG("Window activation sent");
-      }
-      return;
-    }
-    curr = curr->next;
+  WindowNode *window = index_lookup(identifier);
+  if (!window) {
+    LOG("Window not found: %s", identifier);
+    return;
   }
 
-  LOG("Window not found: %s", identifier);
+  LOG("Found window to activate: %s", window->title);
+
+  // update activation history: move window to the front
+  move_window_to_front(window);
+
+  // send activation request
+  // the daemon's loop flushes the request before it next polls
+  if (window->handle && seat) {
+    LOG("Activating window via WLR protocol: %s", window->title);
+    zwlr_foreign_toplevel_handle_v1_activate(window->handle, seat);
+    LOG("Window activation queued");
+  } else if (!seat) {
+    LOG("No seat, cannot activate window");
+  }
 }
 
 const char *wlr_get_name(void) { return "wlr"; }
\ No newline at end of file
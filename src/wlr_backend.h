@@ -4,10 +4,24 @@
 
 #include "backend.h"
 #include "data.h"
+#include <stdint.h>
+
+/* Daemon's seat (main.c), used to activate windows */
+extern struct wl_seat *seat;
 
 /* Initialize wlr backend */
 int wlr_backend_init(void);
 
+/* Bind the toplevel manager when the daemon's registry announces it */
+void wlr_backend_bind_global(struct wl_registry *registry, uint32_t name,
+                             const char *interface, uint32_t version);
+
+/* Generation of the window list, bumped on every change */
+uint64_t wlr_get_generation(void);
+
+/* Forget an output that went away */
+void wlr_backend_remove_global(uint32_t name);
+
 /* Cleanup wlr backend */
 void wlr_backend_cleanup(void);
 
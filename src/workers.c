@@ -0,0 +1,134 @@
+/* src/workers.c - Small pool of render threads */
+#define _POSIX_C_SOURCE 200809L
+
+#include "workers.h"
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#define LOG(fmt, ...) fprintf(stderr, "[Workers] " fmt "\n", ##__VA_ARGS__)
+
+static pthread_t threads[WORKERS_MAX];
+static int nthreads = 0; /* Not counting the daemon thread */
+static void (*thread_exit_fn)(void) = NULL;
+
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t work_ready = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t work_done = PTHREAD_COND_INITIALIZER;
+
+/* Current batch, guarded by lock */
+static void (*job_fn)(void *, int) = NULL;
+static void *job_arg = NULL;
+static int job_count = 0;
+static int job_next = 0;
+static int job_running = 0; /* Indices taken but not finished */
+static unsigned long batch = 0;
+static bool stopping = false;
+
+/* Take indices of the current batch until none are left */
+static void drain_batch(void) {
+  while (job_next < job_count) {
+    int index = job_next++;
+    job_running++;
+    void (*fn)(void *, int) = job_fn;
+    void *arg = job_arg;
+
+    pthread_mutex_unlock(&lock);
+    fn(arg, index);
+    pthread_mutex_lock(&lock);
+
+    if (--job_running == 0 && job_next >= job_count)
+      pthread_cond_broadcast(&work_done);
+  }
+}
+
+static void *worker_main(void *data) {
+  (void)data;
+  unsigned long seen = 0;
+
+  pthread_mutex_lock(&lock);
+  while (!stopping) {
+    if (batch == seen) {
+      pthread_cond_wait(&work_ready, &lock);
+      continue;
+    }
+    seen = batch;
+    drain_batch();
+  }
+  pthread_mutex_unlock(&lock);
+
+  if (thread_exit_fn)
+    thread_exit_fn();
+  return NULL;
+}
+
+void workers_init(int n, void (*on_exit)(void)) {
+  workers_cleanup();
+
+  if (n <= 0) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    n = cpus > 4 ? 4 : (cpus > 0 ? (int)cpus : 1);
+  }
+  if (n > WORKERS_MAX)
+    n = WORKERS_MAX;
+
+  thread_exit_fn = on_exit;
+  stopping = false;
+  for (int i = 0; i < n - 1; i++) {
+    if (pthread_create(&threads[nthreads], NULL, worker_main, NULL) != 0) {
+      LOG("Could not start thread %d, continuing with %d", i + 1, nthreads + 1);
+      break;
+    }
+    nthreads++;
+  }
+  if (nthreads > 0)
+    LOG("Rendering on %d threads", nthreads + 1);
+}
+
+int workers_count(void) { return nthreads + 1; }
+
+void workers_run(void (*fn)(void *arg, int index), void *arg, int count) {
+  if (count <= 0)
+    return;
+
+  /* Nothing to share the work with */
+  if (nthreads == 0 || count == 1) {
+    for (int i = 0; i < count; i++)
+      fn(arg, i);
+    return;
+  }
+
+  pthread_mutex_lock(&lock);
+  job_fn = fn;
+  job_arg = arg;
+  job_count = count;
+  job_next = 0;
+  job_running = 0;
+  batch++;
+  pthread_cond_broadcast(&work_ready);
+
+  drain_batch();
+  while (job_running > 0)
+    pthread_cond_wait(&work_done, &lock);
+
+  job_fn = NULL;
+  job_arg = NULL;
+  job_count = 0;
+  pthread_mutex_unlock(&lock);
+}
+
+void workers_cleanup(void) {
+  if (nthreads == 0)
+    return;
+
+  pthread_mutex_lock(&lock);
+  stopping = true;
+  pthread_cond_broadcast(&work_ready);
+  pthread_mutex_unlock(&lock);
+
+  for (int i = 0; i < nthreads; i++)
+    pthread_join(threads[i], NULL);
+  nthreads = 0;
+  stopping = false;
+}
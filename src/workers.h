@@ -0,0 +1,29 @@
+/* src/workers.h - Small pool of render threads */
+#ifndef WORKERS_H
+#define WORKERS_H
+
+/*
+ * A fixed set of threads that run index-parallel jobs for the daemon
+ * thread, which takes part itself and blocks until every index is done.
+ * Jobs must not touch state the daemon thread uses concurrently; nothing
+ * else runs while workers_run() waits.
+ */
+#define WORKERS_MAX 16
+
+/*
+ * Start the pool with n threads in total, counting the caller (n <= 0
+ * picks one per online CPU, up to 4). on_exit runs on each thread as it
+ * stops, to free thread-local caches.
+ */
+void workers_init(int n, void (*on_exit)(void));
+
+/* Threads taking part in workers_run(), including the caller */
+int workers_count(void);
+
+/* Run fn(arg, i) for every i in [0, count) and wait for all of them */
+void workers_run(void (*fn)(void *arg, int index), void *arg, int count);
+
+/* Stop and join the threads */
+void workers_cleanup(void);
+
+#endif /* WORKERS_H */
@@ -0,0 +1,102 @@
+/* tests/arena_test.c - Offline checks for the snapshot arenas */
+#include "../src/data.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SHOW_CYCLES 50
+/* Each of the two arenas grows on its first show and coalesces on its next */
+#define WARMUP_CYCLES 4
+
+static int failures = 0;
+
+#define CHECK(cond, ...)                                                       \
+  do {                                                                         \
+    if (!(cond)) {                                                             \
+      failures++;                                                              \
+      fprintf(stderr, "FAIL %s:%d: ", __FILE__, __LINE__);                     \
+      fprintf(stderr, __VA_ARGS__);                                            \
+      fprintf(stderr, "\n");                                                   \
+    }                                                                          \
+  } while (0)
+
+/*
+ * One show as the backends build it: a fresh snapshot, the window list
+ * reserved up front, every string copied, and scratch space for grouping.
+ */
+static void build_snapshot(AppState *state, int windows) {
+  app_state_begin_snapshot(state);
+  CHECK(app_state_reserve(state, windows) == 0, "reserve %d", windows);
+
+  for (int i = 0; i < windows; i++) {
+    char title[96], address[32];
+    snprintf(title, sizeof(title), "Document %d - notes and drafts.md", i);
+    snprintf(address, sizeof(address), "0x%x", 0x5000 + i);
+
+    WindowInfo info = {0};
+    info.address = app_state_strdup(state, address);
+    info.title = app_state_strdup(state, title);
+    info.class_name = app_state_strdup(state, i % 2 ? "kitty" : "firefox");
+    info.workspace_id = i % 4;
+    info.group_count = 1;
+    CHECK(app_state_add(state, &info) == 0, "add window %d", i);
+  }
+
+  void *scratch = arena_alloc(&state->snapshots[state->current],
+                              (size_t)windows * 3 * sizeof(int));
+  CHECK(scratch != NULL, "scratch for %d windows", windows);
+}
+
+/* After a few shows the arenas fit the workload and stop growing */
+static void test_steady_state(int windows) {
+  AppState state;
+  app_state_init(&state);
+
+  for (int i = 0; i < WARMUP_CYCLES; i++)
+    build_snapshot(&state, windows);
+
+  size_t before = heap_allocations();
+  for (int i = 0; i < SHOW_CYCLES; i++)
+    build_snapshot(&state, windows);
+  size_t allocs = heap_allocations() - before;
+  CHECK(allocs == 0, "%d windows: %zu heap allocations over %d shows",
+        windows, allocs, SHOW_CYCLES);
+
+  /* The previous snapshot survives until the one after the next */
+  CHECK(state.count == windows &&
+            strcmp(state.windows[windows - 1].class_name,
+                   (windows - 1) % 2 ? "kitty" : "firefox") == 0,
+        "%d windows: last snapshot intact", windows);
+  app_state_free(&state);
+}
+
+static void test_arena_strings(void) {
+  Arena arena = {0};
+  char *a = arena_strdup(&arena, "kitty");
+  char *b = arena_strdup(&arena, NULL);
+  CHECK(a && strcmp(a, "kitty") == 0, "copy '%s'", a ? a : "(null)");
+  CHECK(b && b[0] == '\0', "NULL copies as \"\"");
+
+  /* Bigger than a block: served from a block of its own */
+  size_t big = 100000;
+  char *c = arena_alloc(&arena, big);
+  CHECK(c != NULL, "large allocation");
+  if (c)
+    memset(c, 'x', big);
+  CHECK(strcmp(a, "kitty") == 0, "earlier copy moved");
+  arena_free(&arena);
+}
+
+int main(void) {
+  test_arena_strings();
+  test_steady_state(10);
+  test_steady_state(200);
+  test_steady_state(2000);
+
+  if (failures) {
+    fprintf(stderr, "%d check(s) failed\n", failures);
+    return 1;
+  }
+  printf("arena: all checks passed\n");
+  return 0;
+}
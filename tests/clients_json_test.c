@@ -0,0 +1,147 @@
+/* tests/clients_json_test.c - Offline checks for the j/clients parser */
+#include "../src/clients_json.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static int failures = 0;
+
+#define CHECK(cond, ...)                                                       \
+  do {                                                                         \
+    if (!(cond)) {                                                             \
+      failures++;                                                              \
+      fprintf(stderr, "FAIL %s:%d: ", __FILE__, __LINE__);                     \
+      fprintf(stderr, __VA_ARGS__);                                            \
+      fprintf(stderr, "\n");                                                   \
+    }                                                                          \
+  } while (0)
+
+/* Parse json into state in chunk-sized pieces, as read() would deliver it */
+static int parse(const char *json, size_t chunk, AppState *state) {
+  app_state_init(state);
+  ClientsParser p;
+  clients_parser_init(&p, state);
+
+  int rc = 0;
+  size_t len = strlen(json);
+  for (size_t off = 0; off < len && rc == 0; off += chunk) {
+    size_t n = len - off < chunk ? len - off : chunk;
+    rc = clients_parser_feed(&p, json + off, n);
+  }
+  if (rc == 0)
+    rc = clients_parser_finish(&p);
+  clients_parser_free(&p);
+  return rc;
+}
+
+/* Every chunking of json must give the same single client */
+static void check_one(const char *json, const char *address,
+                      const char *title, const char *cls, int workspace) {
+  size_t len = strlen(json);
+  for (size_t chunk = 1; chunk <= len; chunk++) {
+    AppState state;
+    int rc = parse(json, chunk, &state);
+    CHECK(rc == 0, "chunk %zu: parse failed", chunk);
+    CHECK(state.count == 1, "chunk %zu: %d clients", chunk, state.count);
+    if (rc == 0 && state.count == 1) {
+      WindowInfo *win = &state.windows[0];
+      CHECK(strcmp(win->address, address) == 0, "chunk %zu: address '%s'",
+            chunk, win->address);
+      CHECK(strcmp(win->title, title) == 0, "chunk %zu: title '%s'", chunk,
+            win->title);
+      CHECK(strcmp(win->class_name, cls) == 0, "chunk %zu: class '%s'", chunk,
+            win->class_name);
+      CHECK(win->workspace_id == workspace, "chunk %zu: workspace %d", chunk,
+            win->workspace_id);
+    }
+    app_state_free(&state);
+  }
+}
+
+static void test_empty_strings(void) {
+  /* Empty first key: the string buffer was never allocated */
+  check_one("[{\"\":1,\"address\":\"0x1\",\"class\":\"a\","
+            "\"workspace\":{\"id\":1}}]",
+            "0x1", "", "a", 1);
+  check_one("[{\"address\":\"\",\"title\":\"\",\"class\":\"\","
+            "\"workspace\":{\"\":\"\",\"id\":2}}]",
+            "", "", "", 2);
+}
+
+static void test_escapes(void) {
+  check_one("[{\"address\":\"0x2\",\"title\":\"a\\\"b\\\\c\\/d\\n\\t\","
+            "\"class\":\"k\\u0069tty\",\"workspace\":{\"id\":-99}}]",
+            "0x2", "a\"b\\c/d\n\t", "kitty", -99);
+  check_one("[{\"address\":\"0x3\",\"title\":\"caf\\u00e9 \\u20ac\","
+            "\"class\":\"x\",\"workspace\":{\"id\":3}}]",
+            "0x3", "caf\xc3\xa9 \xe2\x82\xac", "x", 3);
+}
+
+static void test_surrogates(void) {
+  /* U+1F600 as a pair, then lone halves */
+  check_one("[{\"address\":\"0x4\",\"title\":\"\\uD83D\\uDE00!\","
+            "\"class\":\"x\",\"workspace\":{\"id\":4}}]",
+            "0x4", "\xf0\x9f\x98\x80!", "x", 4);
+  check_one("[{\"address\":\"0x5\",\"title\":\"\\uD83Dx\\uDE00\\uD83D\","
+            "\"class\":\"x\",\"workspace\":{\"id\":5}}]",
+            "0x5", "\xef\xbf\xbdx\xef\xbf\xbd\xef\xbf\xbd", "x", 5);
+  check_one("[{\"address\":\"0x6\",\"title\":\"\\uD83D\\u0041\","
+            "\"class\":\"x\",\"workspace\":{\"id\":6}}]",
+            "0x6", "\xef\xbf\xbd" "A", "x", 6);
+}
+
+static void test_fields(void) {
+  AppState state;
+  const char *json =
+      "[{\"address\":\"0xa\",\"class\":\"a\",\"focusHistoryID\":1,"
+      "\"floating\":true,\"workspace\":{\"id\":1,\"name\":\"1\"},"
+      "\"tags\":[\"x\",{\"class\":\"ignored\"}]},"
+      "{\"address\":\"0xb\",\"class\":\"b\",\"focusHistoryID\":0,"
+      "\"floating\":false,\"workspace\":{\"id\":2}},"
+      "{\"address\":\"0xc\",\"class\":\"c\"}]";
+  CHECK(parse(json, 7, &state) == 0, "parse failed");
+  CHECK(state.count == 2, "%d clients (one has no workspace)", state.count);
+  if (state.count == 2) {
+    CHECK(state.windows[0].is_floating && !state.windows[0].is_active,
+          "first client flags");
+    CHECK(strcmp(state.windows[0].class_name, "a") == 0, "nested class '%s'",
+          state.windows[0].class_name);
+    CHECK(!state.windows[1].is_floating && state.windows[1].is_active,
+          "second client flags");
+    CHECK(state.windows[1].focus_history_id == 0, "focus %d",
+          state.windows[1].focus_history_id);
+  }
+  app_state_free(&state);
+}
+
+static void test_malformed(void) {
+  static const char *bad[] = {"",
+                              "{}",
+                              "[",
+                              "[{\"a\":1}",
+                              "[1]]",
+                              "[{\"a\":\"\\uZZZZ\"}]",
+                              "[\"x\"",
+                              "[{\"a\":1}]]"};
+  for (size_t i = 0; i < sizeof(bad) / sizeof(bad[0]); i++) {
+    AppState state;
+    CHECK(parse(bad[i], 3, &state) < 0, "accepted '%s'", bad[i]);
+    app_state_free(&state);
+  }
+}
+
+int main(void) {
+  test_empty_strings();
+  test_escapes();
+  test_surrogates();
+  test_fields();
+  test_malformed();
+  atoms_cleanup();
+
+  if (failures) {
+    fprintf(stderr, "%d check(s) failed\n", failures);
+    return 1;
+  }
+  printf("clients_json: all checks passed\n");
+  return 0;
+}
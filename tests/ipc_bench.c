@@ -0,0 +1,162 @@
+/* tests/ipc_bench.c - Time the Hyprland backend against a replayed session
+ *
+ * Usage: ipc_bench <runtime_dir> <signature> [iterations]
+ *
+ * Expects tests/ipc_replay serving <runtime_dir>/hypr/<signature>. The
+ * j/clients fetch is timed on its own through hyprland_fetch_sync(),
+ * without the event-driven model hiding it.
+ */
+#include "../src/atoms.h"
+#include "../src/capture.h"
+#include "../src/hyprland.h"
+#include "../src/ipc_trace.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define REPLY_TIMEOUT_MS 500
+/* Shows before the snapshot arenas have grown to fit the window list */
+#define WARMUP_SHOWS 4
+
+/* Previews need a Wayland connection; the bench has none */
+bool capture_available(void) { return false; }
+void capture_request(const char *address) { (void)address; }
+void capture_forget(const char *address) { (void)address; }
+
+typedef struct {
+  const char *name;
+  long long *samples;
+  int count;
+} Timing;
+
+static int compare_ll(const void *a, const void *b) {
+  long long x = *(const long long *)a, y = *(const long long *)b;
+  return (x > y) - (x < y);
+}
+
+static void report(Timing *t) {
+  if (t->count == 0) {
+    printf("%-10s no samples\n", t->name);
+    return;
+  }
+  qsort(t->samples, t->count, sizeof(long long), compare_ll);
+  int p99 = (t->count * 99) / 100;
+  if (p99 >= t->count)
+    p99 = t->count - 1;
+  printf("%-10s min %7lld us  median %7lld us  p99 %7lld us\n", t->name,
+         t->samples[0], t->samples[t->count / 2], t->samples[p99]);
+}
+
+int main(int argc, char **argv) {
+  if (argc < 3) {
+    fprintf(stderr, "Usage: %s <runtime_dir> <signature> [iterations]\n",
+            argv[0]);
+    return 2;
+  }
+  int iterations = argc > 3 ? atoi(argv[3]) : 200;
+  if (iterations <= 0)
+    iterations = 200;
+
+  setenv("XDG_RUNTIME_DIR", argv[1], 1);
+  setenv("HYPRLAND_INSTANCE_SIGNATURE", argv[2], 1);
+  Config overview_cfg = {.mode = MODE_OVERVIEW};
+  Config context_cfg = {.mode = MODE_CONTEXT};
+  AppState state;
+  app_state_init(&state);
+
+  /* Focus targets outlive the snapshots rebuilt below */
+  if (hyprland_backend_init() < 0 ||
+      update_window_list(&state, &overview_cfg) < 0 || state.count == 0) {
+    fprintf(stderr, "No replay server or empty trace\n");
+    return 1;
+  }
+  int windows = state.count;
+  char **addresses = calloc(windows, sizeof(char *));
+  for (int i = 0; i < windows; i++)
+    addresses[i] = strdup(state.windows[i].address);
+
+  Timing fetch_t = {"fetch", calloc(iterations, sizeof(long long)), 0};
+  Timing overview_t = {"overview", calloc(iterations, sizeof(long long)), 0};
+  Timing context_t = {"context", calloc(iterations, sizeof(long long)), 0};
+  Timing switch_t = {"switch", calloc(iterations, sizeof(long long)), 0};
+  Timing batch_t = {"batch", calloc(iterations, sizeof(long long)), 0};
+  int batch_misses = 0;
+  size_t show_allocs = 0;
+
+  for (int i = 0; i < iterations; i++) {
+    /* Full j/clients round trip and parse, as on resync */
+    long long start = ipc_trace_now_us();
+    if (hyprland_fetch_sync() == 0)
+      fetch_t.samples[fetch_t.count++] = ipc_trace_now_us() - start;
+
+    size_t allocs_before = heap_allocations();
+    start = ipc_trace_now_us();
+    app_state_begin_snapshot(&state);
+    if (update_window_list(&state, &overview_cfg) == 0)
+      overview_t.samples[overview_t.count++] = ipc_trace_now_us() - start;
+
+    start = ipc_trace_now_us();
+    app_state_begin_snapshot(&state);
+    if (update_window_list(&state, &context_cfg) == 0)
+      context_t.samples[context_t.count++] = ipc_trace_now_us() - start;
+    if (i >= WARMUP_SHOWS)
+      show_allocs += heap_allocations() - allocs_before;
+
+    /* Focus round trip, including the reply drained later */
+    const char *address = addresses[i % windows];
+    start = ipc_trace_now_us();
+    switch_to_window(address);
+    hyprland_flush_replies(REPLY_TIMEOUT_MS);
+    switch_t.samples[switch_t.count++] = ipc_trace_now_us() - start;
+
+    /* Focus and raise as one [[BATCH]] request, waiting for both replies */
+    char focus[128], raise[128];
+    snprintf(focus, sizeof(focus), "dispatch focuswindow address:%s",
+             address);
+    snprintf(raise, sizeof(raise), "dispatch alterzorder top,address:%s",
+             address);
+    const char *cmds[] = {focus, raise};
+    start = ipc_trace_now_us();
+    char *reply = hyprland_command(cmds, 2, true);
+    if (reply && strcmp(reply, "okok") == 0)
+      batch_t.samples[batch_t.count++] = ipc_trace_now_us() - start;
+    else
+      batch_misses++;
+    free(reply);
+  }
+
+  printf("%d windows, %d iterations\n", windows, iterations);
+  report(&fetch_t);
+  report(&overview_t);
+  report(&context_t);
+  report(&switch_t);
+  report(&batch_t);
+  printf("show heap allocations after warmup: %zu\n", show_allocs);
+
+  free(fetch_t.samples);
+  free(overview_t.samples);
+  free(context_t.samples);
+  free(switch_t.samples);
+  free(batch_t.samples);
+  for (int i = 0; i < windows; i++)
+    free(addresses[i]);
+  free(addresses);
+  app_state_free(&state);
+  hyprland_backend_cleanup();
+  atoms_cleanup();
+
+  /* Steady-state snapshots must come entirely from the arenas */
+  if (show_allocs > 0) {
+    fprintf(stderr, "Snapshots made %zu heap allocations after warmup\n",
+            show_allocs);
+    return 1;
+  }
+
+  /* Recorded sessions may hold no batches; synthetic ones answer every one */
+  if (batch_t.count > 0 && batch_misses > 0) {
+    fprintf(stderr, "%d batched requests got no matching reply\n",
+            batch_misses);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,380 @@
+/* tests/ipc_replay.c - Serve recorded Hyprland IPC traces from a fake socket
+ *
+ *   ipc_replay serve <trace> <dir> [--realtime]
+ *       Listen on <dir>/.socket.sock and <dir>/.socket2.sock. Each request
+ *       is answered with the next recorded response for the same request
+ *       (cycling), "unknown request" otherwise. --realtime waits for the
+ *       recorded duration before answering.
+ *
+ *   ipc_replay generate <windows> [seed]
+ *       Write a synthetic trace to stdout: one j/clients exchange with
+ *       <windows> clients in Hyprland's own layout, plus a focuswindow
+ *       dispatch for each of them, alone and batched with a raise.
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include "../src/ipc_trace.h"
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+#define MAX_EVENT_CLIENTS 16
+
+typedef struct {
+  IpcTraceEntry *entries;
+  int count;
+  int *cursor; /* Per entry: next occurrence to serve for its request */
+} Trace;
+
+static volatile sig_atomic_t quit = 0;
+static void on_signal(int sig) {
+  (void)sig;
+  quit = 1;
+}
+
+/* --- Serving --- */
+
+static int load_trace(const char *path, Trace *trace) {
+  FILE *f = fopen(path, "r");
+  if (!f) {
+    perror(path);
+    return -1;
+  }
+
+  int cap = 0, rc;
+  IpcTraceEntry entry;
+  memset(trace, 0, sizeof(*trace));
+  while ((rc = ipc_trace_read(f, &entry)) > 0) {
+    if (trace->count == cap) {
+      cap = cap ? cap * 2 : 64;
+      trace->entries = realloc(trace->entries, cap * sizeof(IpcTraceEntry));
+      if (!trace->entries) {
+        fclose(f);
+        return -1;
+      }
+    }
+    trace->entries[trace->count++] = entry;
+  }
+  fclose(f);
+
+  if (rc < 0) {
+    fprintf(stderr, "%s: malformed trace after %d entries\n", path,
+            trace->count);
+    return -1;
+  }
+  trace->cursor = calloc(trace->count ? trace->count : 1, sizeof(int));
+  return trace->cursor ? 0 : -1;
+}
+
+/*
+ * Recorded exchanges for the same request are served in order, wrapping
+ * around, so a replayed session sees the same sequence of answers.
+ */
+static const IpcTraceEntry *find_response(Trace *trace, const char *req,
+                                          size_t len) {
+  int first = -1, matches = 0;
+  for (int i = 0; i < trace->count; i++) {
+    IpcTraceEntry *e = &trace->entries[i];
+    if (e->request_len == len && memcmp(e->request, req, len) == 0) {
+      if (first < 0)
+        first = i;
+      matches++;
+    }
+  }
+  if (first < 0)
+    return NULL;
+
+  int want = trace->cursor[first]++ % matches;
+  for (int i = first; i < trace->count; i++) {
+    IpcTraceEntry *e = &trace->entries[i];
+    if (e->request_len == len && memcmp(e->request, req, len) == 0 &&
+        want-- == 0)
+      return e;
+  }
+  return NULL;
+}
+
+static int listen_at(const char *dir, const char *name) {
+  struct sockaddr_un addr = {.sun_family = AF_UNIX};
+  snprintf(addr.sun_path, sizeof(addr.sun_path), "%s/%s", dir, name);
+  unlink(addr.sun_path);
+
+  int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd < 0 || bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+      listen(fd, 64) < 0) {
+    perror(addr.sun_path);
+    return -1;
+  }
+  return fd;
+}
+
+static void write_all(int fd, const char *buf, size_t len) {
+  while (len > 0) {
+    ssize_t n = write(fd, buf, len);
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n <= 0)
+      return;
+    buf += n;
+    len -= n;
+  }
+}
+
+static void serve_request(int client, Trace *trace, bool realtime) {
+  char req[8192];
+  ssize_t n;
+  do {
+    n = read(client, req, sizeof(req));
+  } while (n < 0 && errno == EINTR);
+  if (n <= 0)
+    return;
+
+  const IpcTraceEntry *e = find_response(trace, req, n);
+  if (!e) {
+    write_all(client, "unknown request", 15);
+    return;
+  }
+
+  if (realtime && e->duration_us > 0) {
+    struct timespec ts = {.tv_sec = e->duration_us / 1000000,
+                          .tv_nsec = (e->duration_us % 1000000) * 1000};
+    nanosleep(&ts, NULL);
+  }
+  write_all(client, e->response, e->response_len);
+}
+
+static int serve(const char *path, const char *dir, bool realtime) {
+  Trace trace;
+  if (load_trace(path, &trace) < 0)
+    return 1;
+
+  int req_fd = listen_at(dir, ".socket.sock");
+  int evt_fd = listen_at(dir, ".socket2.sock");
+  if (req_fd < 0 || evt_fd < 0)
+    return 1;
+
+  fprintf(stderr, "Serving %d recorded exchanges from %s/.socket.sock\n",
+          trace.count, dir);
+
+  /* Event subscribers are accepted and kept open, but never sent events */
+  int event_clients[MAX_EVENT_CLIENTS];
+  int event_count = 0;
+
+  signal(SIGINT, on_signal);
+  signal(SIGTERM, on_signal);
+  signal(SIGPIPE, SIG_IGN);
+
+  while (!quit) {
+    struct pollfd fds[2] = {{.fd = req_fd, .events = POLLIN},
+                            {.fd = evt_fd, .events = POLLIN}};
+    if (poll(fds, 2, 200) < 0) {
+      if (errno == EINTR)
+        continue;
+      break;
+    }
+
+    if (fds[1].revents & POLLIN) {
+      int c = accept(evt_fd, NULL, NULL);
+      if (c >= 0 && event_count < MAX_EVENT_CLIENTS)
+        event_clients[event_count++] = c;
+      else if (c >= 0)
+        close(c);
+    }
+
+    if (fds[0].revents & POLLIN) {
+      int c = accept(req_fd, NULL, NULL);
+      if (c >= 0) {
+        serve_request(c, &trace, realtime);
+        close(c);
+      }
+    }
+  }
+
+  for (int i = 0; i < event_count; i++)
+    close(event_clients[i]);
+  close(req_fd);
+  close(evt_fd);
+
+  char sock[512];
+  snprintf(sock, sizeof(sock), "%s/.socket.sock", dir);
+  unlink(sock);
+  snprintf(sock, sizeof(sock), "%s/.socket2.sock", dir);
+  unlink(sock);
+
+  for (int i = 0; i < trace.count; i++)
+    ipc_trace_entry_free(&trace.entries[i]);
+  free(trace.entries);
+  free(trace.cursor);
+  return 0;
+}
+
+/* --- Synthetic Traces --- */
+
+static const char *classes[] = {
+    "kitty",         "firefox",     "code-oss",  "org.gnome.Nautilus",
+    "Slack",         "discord",     "obsidian",  "jetbrains-idea",
+    "mpv",           "thunderbird", "Alacritty", "org.telegram.desktop",
+    "chromium",      "spotify",     "zathura",   "pavucontrol",
+    "google-chrome", "foot",        "steam",     "org.wezfurlong.wezterm",
+};
+#define NUM_CLASSES (int)(sizeof(classes) / sizeof(classes[0]))
+
+static const char *titles[] = {
+    "~/src/snappy-switcher",
+    "Pull request #214 · Fix focus race — Mozilla Firefox",
+    "main.c - snappy-switcher - Code - OSS",
+    "Downloads",
+    "#general | Team — Slack",
+    "vim ~/.config/hypr/hyprland.conf",
+    "Inbox (42) — Thunderbird",
+    "\\u00c9t\\u00e9 \\u2014 notes.md - Obsidian",
+    "htop",
+    "Video \\\"Demo\\\" [1080p].mkv - mpv",
+};
+#define NUM_TITLES (int)(sizeof(titles) / sizeof(titles[0]))
+
+static unsigned int rng_state;
+static unsigned int rng(void) {
+  rng_state = rng_state * 1103515245u + 12345u;
+  return (rng_state >> 16) & 0x7fff;
+}
+
+static int append(TraceBuf *buf, const char *fmt, ...) {
+  char tmp[1024];
+  va_list ap;
+  va_start(ap, fmt);
+  int n = vsnprintf(tmp, sizeof(tmp), fmt, ap);
+  va_end(ap);
+  if (n < 0 || (size_t)n >= sizeof(tmp))
+    return -1;
+  return trace_buf_append(buf, tmp, n);
+}
+
+static int generate(int windows, unsigned int seed) {
+  rng_state = seed;
+  unsigned long long *addrs = calloc(windows ? windows : 1, sizeof(*addrs));
+  int *order = calloc(windows ? windows : 1, sizeof(int));
+  if (!addrs || !order)
+    return 1;
+
+  /* Focus history is a random permutation of the windows */
+  for (int i = 0; i < windows; i++)
+    order[i] = i;
+  for (int i = windows - 1; i > 0; i--) {
+    int j = rng() % (i + 1);
+    int t = order[i];
+    order[i] = order[j];
+    order[j] = t;
+  }
+
+  TraceBuf json = {0};
+  append(&json, "[");
+  for (int i = 0; i < windows; i++) {
+    addrs[i] = 0x55d4c7a00000ull + (unsigned long long)i * 0x1a40 + rng();
+    const char *cls = classes[rng() % NUM_CLASSES];
+    int ws = rng() % 100 < 4 ? -98 : 1 + (int)(rng() % 10);
+    bool floating = rng() % 100 < 15;
+
+    append(&json, "%s{\n", i ? ", " : "");
+    append(&json, "    \"address\": \"0x%llx\",\n", addrs[i]);
+    append(&json, "    \"mapped\": true,\n    \"hidden\": false,\n");
+    append(&json, "    \"at\": [%u, %u],\n", rng() % 2560, rng() % 1440);
+    append(&json, "    \"size\": [%u, %u],\n", 200 + rng() % 2360,
+           150 + rng() % 1290);
+    if (ws < 0)
+      append(&json,
+             "    \"workspace\": {\n        \"id\": %d,\n"
+             "        \"name\": \"special:magic\"\n    },\n",
+             ws);
+    else
+      append(&json,
+             "    \"workspace\": {\n        \"id\": %d,\n"
+             "        \"name\": \"%d\"\n    },\n",
+             ws, ws);
+    append(&json, "    \"floating\": %s,\n    \"pseudo\": false,\n",
+           floating ? "true" : "false");
+    append(&json, "    \"monitor\": %u,\n", rng() % 2);
+    append(&json, "    \"class\": \"%s\",\n", cls);
+    append(&json, "    \"title\": \"%s\",\n", titles[rng() % NUM_TITLES]);
+    append(&json, "    \"initialClass\": \"%s\",\n", cls);
+    append(&json, "    \"initialTitle\": \"%s\",\n", cls);
+    append(&json, "    \"pid\": %u,\n", 1000 + rng() % 60000);
+    append(&json, "    \"xwayland\": %s,\n", rng() % 10 ? "false" : "true");
+    append(&json, "    \"pinned\": false,\n    \"fullscreen\": 0,\n");
+    append(&json, "    \"fullscreenClient\": 0,\n");
+    append(&json, "    \"grouped\": [],\n    \"tags\": [],\n");
+    append(&json, "    \"swallowing\": \"0x0\",\n");
+    append(&json, "    \"focusHistoryID\": %d,\n", order[i]);
+    append(&json, "    \"inhibitingIdle\": false\n}");
+  }
+  append(&json, "]");
+
+  fputs(IPC_TRACE_HEADER, stdout);
+  IpcTraceEntry e = {.start_us = 0,
+                     .duration_us = 1500 + windows * 12,
+                     .request = "j/clients",
+                     .request_len = 9,
+                     .response = json.data,
+                     .response_len = json.len};
+  ipc_trace_write(stdout, &e);
+
+  for (int i = 0; i < windows; i++) {
+    char cmd[96];
+    snprintf(cmd, sizeof(cmd), "dispatch focuswindow address:0x%llx",
+             addrs[i]);
+    IpcTraceEntry d = {.start_us = 10000 + i * 250000LL,
+                       .duration_us = 300,
+                       .request = cmd,
+                       .request_len = strlen(cmd),
+                       .response = "ok",
+                       .response_len = 2};
+    ipc_trace_write(stdout, &d);
+
+    /* Focus and raise in one [[BATCH]] request; replies are concatenated */
+    char batch[192];
+    snprintf(batch, sizeof(batch),
+             "[[BATCH]]dispatch focuswindow address:0x%llx;"
+             "dispatch alterzorder top,address:0x%llx",
+             addrs[i], addrs[i]);
+    IpcTraceEntry b = {.start_us = d.start_us + 1000,
+                       .duration_us = 450,
+                       .request = batch,
+                       .request_len = strlen(batch),
+                       .response = "okok",
+                       .response_len = 4};
+    ipc_trace_write(stdout, &b);
+  }
+
+  trace_buf_free(&json);
+  free(addrs);
+  free(order);
+  return 0;
+}
+
+static void usage(void) {
+  fprintf(stderr, "Usage: ipc_replay serve <trace> <dir> [--realtime]\n"
+                  "       ipc_replay generate <windows> [seed]\n");
+}
+
+int main(int argc, char **argv) {
+  if (argc >= 4 && strcmp(argv[1], "serve") == 0) {
+    bool realtime = argc >= 5 && strcmp(argv[4], "--realtime") == 0;
+    return serve(argv[2], argv[3], realtime);
+  }
+  if (argc >= 3 && strcmp(argv[1], "generate") == 0) {
+    unsigned int seed = argc >= 4 ? (unsigned int)strtoul(argv[3], NULL, 10)
+                                  : 1;
+    return generate(atoi(argv[2]), seed);
+  }
+  usage();
+  return 1;
+}
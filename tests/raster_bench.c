@@ -0,0 +1,120 @@
+/* tests/raster_bench.c - Card rasterization scaling across render threads
+ *
+ * Usage: raster_bench [windows] [iterations] [max_threads]
+ *
+ * Draws cold frames of a synthetic grid through render_ui() into the
+ * headless sink (sprite, background and text caches emptied before each
+ * frame, as after a theme change) with 1 up to max_threads render threads.
+ * Needs cairo and pango but no compositor.
+ */
+#include "../src/atoms.h"
+#include "../src/blit.h"
+#include "../src/config.h"
+#include "../src/headless.h"
+#include "../src/icons.h"
+#include "../src/render.h"
+#include "../src/text.h"
+#include "../src/workers.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/* Normally owned by main.c; frames here never reach a surface */
+struct wl_shm *shm = NULL;
+struct wl_surface *surface = NULL;
+
+static const char *classes[] = {"kitty",   "firefox", "code",
+                                "thunar",  "discord", "obsidian",
+                                "spotify", "gimp",    "foot"};
+#define NUM_CLASSES (sizeof(classes) / sizeof(classes[0]))
+
+static long long now_us(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (long long)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static int compare_ll(const void *a, const void *b) {
+  long long x = *(const long long *)a, y = *(const long long *)b;
+  return (x > y) - (x < y);
+}
+
+int main(int argc, char **argv) {
+  int windows = argc > 1 ? atoi(argv[1]) : 60;
+  int iterations = argc > 2 ? atoi(argv[2]) : 20;
+  long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+  int max_threads = argc > 3 ? atoi(argv[3]) : (cpus > 0 ? (int)cpus : 1);
+  if (windows < 1 || iterations < 1 || max_threads < 1) {
+    fprintf(stderr, "Usage: %s [windows] [iterations] [max_threads]\n",
+            argv[0]);
+    return 2;
+  }
+  if (max_threads > WORKERS_MAX)
+    max_threads = WORKERS_MAX;
+
+  Config *config = get_default_config();
+  render_set_sink(&headless_sink);
+  blit_init();
+  config->max_cols = 10;
+  icons_init(config->icon_theme, config->icon_fallback);
+
+  AppState state = {0};
+  state.windows = calloc(windows, sizeof(WindowInfo));
+  state.count = windows;
+  for (int i = 0; i < windows; i++) {
+    char title[96];
+    snprintf(title, sizeof(title), "Document %d - notes and drafts.md", i);
+    WindowInfo *win = &state.windows[i];
+    win->title = strdup(title);
+    win->address = strdup(title);
+    win->class_atom = atom_intern(classes[i % NUM_CLASSES]);
+    win->group_count = (i % 7 == 0) ? 3 : 1;
+  }
+  state.selected_index = 1;
+  render_set_config(config);
+  calculate_dimensions(&state, &state.width, &state.height);
+
+  long long *samples = calloc(iterations, sizeof(long long));
+  long long base = 0;
+
+  printf("%d windows, %ux%u, %d iterations\n", windows, state.width,
+         state.height, iterations);
+
+  for (int threads = 1; threads <= max_threads; threads++) {
+    workers_init(threads, text_cleanup);
+
+    /* One untimed frame loads the icons */
+    for (int i = -1; i < iterations; i++) {
+      render_set_config(config); /* Cold sprites, background and text */
+      long long start = now_us();
+      render_ui(&state, state.width, state.height);
+      long long took = now_us() - start;
+      if (i >= 0)
+        samples[i] = took;
+    }
+
+    qsort(samples, iterations, sizeof(long long), compare_ll);
+    long long median = samples[iterations / 2];
+    if (threads == 1)
+      base = median;
+    printf("threads %2d  min %7lld us  median %7lld us  speedup %.2fx\n",
+           workers_count(), samples[0], median,
+           median > 0 ? (double)base / median : 0.0);
+  }
+
+  workers_cleanup();
+  render_cleanup();
+  headless_cleanup();
+  icons_cleanup();
+  for (int i = 0; i < windows; i++) {
+    free(state.windows[i].title);
+    free(state.windows[i].address);
+  }
+  free(state.windows);
+  free(samples);
+  free_config(config);
+  atoms_cleanup();
+  return 0;
+}
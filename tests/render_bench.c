@@ -0,0 +1,376 @@
+/* tests/render_bench.c - Headless frame timing and golden-image hashes
+ *
+ * Usage: render_bench [--check FILE | --update FILE] [--png DIR]
+ *                     [iterations]
+ *
+ * Renders synthetic snapshots through render_ui() into the headless sink
+ * for several window counts, themes and modes, and times the first frame
+ * (all caches cold) and navigation frames (selection moved by one). Needs
+ * cairo and pango but no compositor or display.
+ *
+ * Every scenario also checks that the partial redraw, the threaded
+ * rasterizer and the scalar blit kernels produce the same pixels as a
+ * single-threaded full frame, and prints that frame's hash. --update
+ * records the hashes in FILE, --check compares against it and fails on any
+ * frame FILE has no hash for. Frame hashes depend on the cairo, pango and
+ * font versions: make test-render pins the font with tests/fonts.conf, and
+ * the classes are made up so no installed icon theme changes the cards.
+ * The "kernels" hash covers only the blit kernels and is the same
+ * everywhere.
+ */
+#include "../src/atoms.h"
+#include "../src/blit.h"
+#include "../src/config.h"
+#include "../src/headless.h"
+#include "../src/icons.h"
+#include "../src/render.h"
+#include "../src/text.h"
+#include "../src/workers.h"
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* Normally owned by main.c; the headless sink never touches them */
+struct wl_shm *shm = NULL;
+struct wl_surface *surface = NULL;
+
+static const int window_counts[] = {10, 50, 200};
+#define NUM_COUNTS (sizeof(window_counts) / sizeof(window_counts[0]))
+
+/* NULL is the built-in theme; paths are relative to the source tree */
+static const char *themes[] = {NULL, "themes/catppuccin-latte.ini",
+                               "themes/nord.ini", "themes/cyberpunk.ini"};
+#define NUM_THEMES (sizeof(themes) / sizeof(themes[0]))
+
+static const char *classes[] = {"bench-alpha", "bench-bravo", "bench-charlie",
+                                "bench-delta", "bench-echo",  "bench-foxtrot",
+                                "bench-golf",  "bench-hotel", "bench-india"};
+#define NUM_CLASSES (sizeof(classes) / sizeof(classes[0]))
+#define NUM_WORKSPACES 4
+
+#define MAX_GOLDEN 128
+
+typedef struct {
+  char name[64];
+  uint64_t hash;
+} Golden;
+
+static Golden golden[MAX_GOLDEN];
+static int golden_count = 0;
+
+static long long now_us(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (long long)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static int compare_ll(const void *a, const void *b) {
+  long long x = *(const long long *)a, y = *(const long long *)b;
+  return (x > y) - (x < y);
+}
+
+static long long median(long long *samples, int n) {
+  qsort(samples, n, sizeof(long long), compare_ll);
+  return samples[n / 2];
+}
+
+/*
+ * A snapshot as the backend would build it: one card per window in
+ * overview mode, one per (class, workspace) group in context mode, in
+ * MRU order either way.
+ */
+static void build_snapshot(AppState *state, int windows, ViewMode mode) {
+  memset(state, 0, sizeof(*state));
+  state->windows = calloc(windows, sizeof(WindowInfo));
+
+  for (int i = 0; i < windows; i++) {
+    Atom cls = atom_intern(classes[i % NUM_CLASSES]);
+    int ws = (i / NUM_CLASSES) % NUM_WORKSPACES;
+
+    if (mode == MODE_CONTEXT) {
+      bool grouped = false;
+      for (int j = 0; j < state->count && !grouped; j++) {
+        WindowInfo *card = &state->windows[j];
+        if (card->class_atom == cls && card->workspace_id == ws) {
+          card->group_count++;
+          grouped = true;
+        }
+      }
+      if (grouped)
+        continue;
+    }
+
+    char title[96];
+    snprintf(title, sizeof(title), "Document %d - notes and drafts.md", i);
+    WindowInfo *win = &state->windows[state->count++];
+    win->title = strdup(title);
+    win->address = strdup(title);
+    win->class_atom = cls;
+    win->workspace_id = ws;
+    win->group_count = 1;
+  }
+  state->selected_index = state->count > 1 ? 1 : 0;
+}
+
+static void free_snapshot(AppState *state) {
+  for (int i = 0; i < state->count; i++) {
+    free(state->windows[i].title);
+    free(state->windows[i].address);
+  }
+  free(state->windows);
+}
+
+/* A full frame from cold caches, with the given number of render threads */
+static uint64_t cold_frame(AppState *state, Config *config, int threads) {
+  workers_init(threads, text_cleanup);
+  render_set_config(config);
+  render_ui(state, state->width, state->height);
+  return headless_hash();
+}
+
+static int load_golden(const char *path) {
+  FILE *f = fopen(path, "r");
+  if (!f)
+    return -1;
+  char line[128];
+  while (golden_count < MAX_GOLDEN && fgets(line, sizeof(line), f)) {
+    Golden *g = &golden[golden_count];
+    if (sscanf(line, "%63s %" SCNx64, g->name, &g->hash) == 2)
+      golden_count++;
+  }
+  fclose(f);
+  return 0;
+}
+
+static const Golden *find_golden(const char *name) {
+  for (int i = 0; i < golden_count; i++)
+    if (strcmp(golden[i].name, name) == 0)
+      return &golden[i];
+  return NULL;
+}
+
+/* Compare against the golden hash; a missing one is a failure too */
+static int check_golden(const char *name, uint64_t hash) {
+  const Golden *g = find_golden(name);
+  if (!g) {
+    printf("FAIL %s: no golden hash (record it with --update)\n", name);
+    return 1;
+  }
+  if (g->hash != hash) {
+    printf("FAIL %s: hash %016" PRIx64 ", golden %016" PRIx64 "\n", name, hash,
+           g->hash);
+    return 1;
+  }
+  return 0;
+}
+
+/*
+ * Rounded fills at fractional positions and radii, translucent and opaque,
+ * then an alpha gradient blitted over them: only blit.c touches the pixels,
+ * so the hash does not depend on cairo, pango or fonts.
+ */
+static uint64_t kernel_hash(void) {
+  enum { W = 256, H = 160 };
+  static uint8_t pixels[W * H * 4], sprite[48 * 40 * 4];
+  memset(pixels, 0, sizeof(pixels));
+  BlitImage dst = {pixels, W * 4, W, H, 0, 0, W, H};
+
+  blit_fill_rounded(&dst, 0, 0, W, H, 14, 0.12, 0.12, 0.18, 0.95);
+  for (int i = 0; i < 6; i++)
+    blit_fill_rounded(&dst, 6.25 + i * 40.5, 10.5 + i * 3.75, 37.5, 60.25,
+                      2.5 + i * 2.25, 0.2 + i * 0.1, 0.9 - i * 0.1, 0.5,
+                      i % 2 ? 1.0 : 0.35 + i * 0.1);
+  blit_fill_rounded(&dst, -10.5, 120.75, 80, 60, 30, 1.0, 0.4, 0.1, 0.8);
+
+  for (int y = 0; y < 40; y++)
+    for (int x = 0; x < 48; x++) {
+      uint32_t a = (uint32_t)(x * 255 / 47), c = a * (uint32_t)y / 39;
+      uint8_t *px = sprite + (y * 48 + x) * 4;
+      px[0] = (uint8_t)c;
+      px[1] = (uint8_t)(a / 2);
+      px[2] = (uint8_t)a;
+      px[3] = (uint8_t)a;
+    }
+  BlitImage src = {sprite, 48 * 4, 48, 40, 0, 0, 48, 40};
+  blit_over(&dst, &src, 100, 90);
+  blit_over(&dst, &src, 230, 140);
+
+  uint64_t h = 14695981039346656037ull;
+  for (size_t i = 0; i < sizeof(pixels); i++) {
+    h ^= pixels[i];
+    h *= 1099511628211ull;
+  }
+  return h;
+}
+
+int main(int argc, char **argv) {
+  const char *check = NULL, *update = NULL, *png_dir = NULL;
+  int iterations = 20;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--check") == 0 && i + 1 < argc)
+      check = argv[++i];
+    else if (strcmp(argv[i], "--update") == 0 && i + 1 < argc)
+      update = argv[++i];
+    else if (strcmp(argv[i], "--png") == 0 && i + 1 < argc)
+      png_dir = argv[++i];
+    else if ((iterations = atoi(argv[i])) < 1) {
+      fprintf(stderr,
+              "Usage: %s [--check FILE | --update FILE] [--png DIR] "
+              "[iterations]\n",
+              argv[0]);
+      return 2;
+    }
+  }
+
+  int failures = 0;
+  if (check && load_golden(check) < 0) {
+    printf("FAIL no golden hashes in %s (record them with --update)\n",
+           check);
+    failures++;
+  }
+  FILE *out = NULL;
+  if (update && !(out = fopen(update, "w"))) {
+    perror(update);
+    return 2;
+  }
+
+  render_set_sink(&headless_sink);
+  blit_init();
+  const char *isa = blit_isa();
+  long long *samples = calloc(iterations, sizeof(long long));
+
+  /* Every kernel variant the CPU runs must give the same pixels */
+  uint64_t kernels = kernel_hash();
+  static const char *isas[] = {"scalar", "sse2", "avx2"};
+  for (size_t i = 0; i < sizeof(isas) / sizeof(isas[0]); i++) {
+    if (!blit_use(isas[i]))
+      continue;
+    if (kernel_hash() != kernels) {
+      printf("FAIL kernels: %s differs from %s\n", isas[i], isa);
+      failures++;
+    }
+  }
+  blit_use(isa);
+  if (out)
+    fprintf(out, "kernels %016" PRIx64 "\n", kernels);
+  if (check)
+    failures += check_golden("kernels", kernels);
+
+  printf("Blit kernels: %s, hash %016" PRIx64 "\n", isa, kernels);
+  printf("%-34s %9s %11s %11s  %s\n", "scenario", "size", "first (us)",
+         "nav (us)", "hash");
+
+  for (size_t t = 0; t < NUM_THEMES; t++) {
+    Config *config = get_default_config();
+    if (themes[t] && config_apply_file(config, themes[t]) < 0) {
+      printf("FAIL cannot read %s\n", themes[t]);
+      free_config(config);
+      failures++;
+      continue;
+    }
+    icons_init(config->icon_theme, config->icon_fallback);
+
+    const char *theme = "default";
+    if (themes[t]) {
+      const char *slash = strrchr(themes[t], '/');
+      theme = slash ? slash + 1 : themes[t];
+    }
+
+    for (int m = 0; m < 2; m++) {
+      ViewMode mode = m ? MODE_CONTEXT : MODE_OVERVIEW;
+      for (size_t c = 0; c < NUM_COUNTS; c++) {
+        char name[64];
+        snprintf(name, sizeof(name), "%s-%d-%.*s",
+                 m ? "context" : "overview", window_counts[c],
+                 (int)(strcspn(theme, ".")), theme);
+
+        AppState state;
+        build_snapshot(&state, window_counts[c], mode);
+        render_set_config(config);
+        calculate_dimensions(&state, &state.width, &state.height);
+
+        /* Reference: one thread, nothing cached; also loads the icons */
+        uint64_t reference = cold_frame(&state, config, 1);
+        if (png_dir) {
+          char path[512];
+          snprintf(path, sizeof(path), "%s/%s.png", png_dir, name);
+          headless_write_png(path);
+        }
+
+        /* Threaded rasterization must not change a pixel */
+        if (cold_frame(&state, config, config->render_threads) != reference) {
+          printf("FAIL %s: threaded frame differs\n", name);
+          failures++;
+        }
+
+        /* Nor may the SIMD kernels */
+        if (strcmp(blit_isa(), "scalar") != 0) {
+          blit_use("scalar");
+          if (cold_frame(&state, config, 1) != reference) {
+            printf("FAIL %s: %s kernels differ from scalar\n", name, isa);
+            failures++;
+          }
+          blit_use(isa);
+        }
+
+        for (int i = 0; i < iterations; i++) {
+          render_set_config(config);
+          long long start = now_us();
+          render_ui(&state, state.width, state.height);
+          samples[i] = now_us() - start;
+        }
+        long long first = median(samples, iterations);
+
+        /* Warm navigation, wrapping like Tab does */
+        for (int i = 0; i < iterations; i++) {
+          state.selected_index = (state.selected_index + 1) % state.count;
+          long long start = now_us();
+          render_ui(&state, state.width, state.height);
+          samples[i] = now_us() - start;
+        }
+        long long nav = median(samples, iterations);
+
+        /* The partial redraw must match a full frame of the same state */
+        uint64_t partial = headless_hash();
+        render_invalidate();
+        render_ui(&state, state.width, state.height);
+        if (headless_hash() != partial) {
+          printf("FAIL %s: selection redraw differs from a full frame\n",
+                 name);
+          failures++;
+        }
+
+        printf("%-34s %4ux%-4u %11lld %11lld  %016" PRIx64 "\n", name,
+               state.width, state.height, first, nav, reference);
+        if (out)
+          fprintf(out, "%s %016" PRIx64 "\n", name, reference);
+
+        if (check)
+          failures += check_golden(name, reference);
+        free_snapshot(&state);
+      }
+    }
+
+    icons_cleanup();
+    render_set_config(NULL);
+    free_config(config);
+  }
+
+  if (out)
+    fclose(out);
+  workers_cleanup();
+  render_cleanup();
+  headless_cleanup();
+  atoms_cleanup();
+  free(samples);
+
+  if (failures) {
+    printf("%d check(s) failed\n", failures);
+    return 1;
+  }
+  if (check)
+    printf("All frames match\n");
+  return 0;
+}
@@ -0,0 +1,158 @@
+/* tests/thumbnail_test.c - Offline checks for preview downscaling and cache */
+#include "../src/thumbnail.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static int failures = 0;
+
+#define CHECK(cond, ...)                                                       \
+  do {                                                                         \
+    if (!(cond)) {                                                             \
+      failures++;                                                              \
+      fprintf(stderr, "FAIL %s:%d: ", __FILE__, __LINE__);                     \
+      fprintf(stderr, __VA_ARGS__);                                            \
+      fprintf(stderr, "\n");                                                   \
+    }                                                                          \
+  } while (0)
+
+/* Synthetic frame with rows padded to stride bytes */
+static uint32_t *make_frame(int w, int h, int stride, uint32_t color) {
+  uint32_t *buf = calloc((size_t)stride * h, 1);
+  for (int y = 0; y < h; y++) {
+    uint32_t *row = (uint32_t *)((char *)buf + (size_t)y * stride);
+    for (int x = 0; x < w; x++)
+      row[x] = color;
+  }
+  return buf;
+}
+
+static void test_fit(void) {
+  int w, h;
+  thumb_fit(1920, 1080, &w, &h);
+  CHECK(w == THUMB_MAX_WIDTH && h == 144, "1920x1080 -> %dx%d", w, h);
+  thumb_fit(1080, 1920, &w, &h);
+  CHECK(h == THUMB_MAX_HEIGHT && w == 90, "1080x1920 -> %dx%d", w, h);
+  thumb_fit(100, 50, &w, &h);
+  CHECK(w == 100 && h == 50, "small source upscaled to %dx%d", w, h);
+  thumb_fit(100000, 10, &w, &h);
+  CHECK(w == THUMB_MAX_WIDTH && h == 1, "extreme aspect -> %dx%d", w, h);
+  thumb_fit(0, 10, &w, &h);
+  CHECK(w == 0 && h == 0, "empty source -> %dx%d", w, h);
+}
+
+static void test_solid(void) {
+  int stride = 1000 * 4 + 64;
+  uint32_t *src = make_frame(1000, 600, stride, 0xff336699);
+  uint32_t dst[128 * 77];
+  thumb_downscale(src, 1000, 600, stride, false, false, dst, 128, 77);
+  for (int i = 0; i < 128 * 77; i++) {
+    if (dst[i] != 0xff336699) {
+      CHECK(0, "solid colour changed at %d: %08x", i, dst[i]);
+      break;
+    }
+  }
+  free(src);
+}
+
+static void test_average(void) {
+  /* 2x2 checkerboard of black and white averages to mid grey */
+  uint32_t src[4] = {0xff000000, 0xffffffff, 0xffffffff, 0xff000000};
+  uint32_t dst[1];
+  thumb_downscale(src, 2, 2, 8, false, false, dst, 1, 1);
+  CHECK(dst[0] == 0xff808080, "checkerboard -> %08x", dst[0]);
+
+  /* XRGB sources have undefined alpha; opaque forces it */
+  uint32_t xrgb[4] = {0x00102030, 0x00102030, 0x00102030, 0x00102030};
+  thumb_downscale(xrgb, 2, 2, 8, false, true, dst, 1, 1);
+  CHECK(dst[0] == 0xff102030, "opaque XRGB -> %08x", dst[0]);
+
+  /* Non-integer ratio: 3 -> 2 keeps every output inside the input range */
+  uint32_t ramp[3] = {0xff000000, 0xff808080, 0xffffffff};
+  uint32_t out[2];
+  thumb_downscale(ramp, 3, 1, 12, false, false, out, 2, 1);
+  CHECK(out[0] == 0xff000000 && out[1] == 0xffc0c0c0, "ramp -> %08x %08x",
+        out[0], out[1]);
+}
+
+static void test_y_invert(void) {
+  /* Top half red, bottom half blue */
+  int w = 64, h = 64, stride = w * 4;
+  uint32_t *src = make_frame(w, h, stride, 0xffff0000);
+  for (int i = w * h / 2; i < w * h; i++)
+    src[i] = 0xff0000ff;
+
+  uint32_t dst[4 * 4];
+  thumb_downscale(src, w, h, stride, false, false, dst, 4, 4);
+  CHECK(dst[0] == 0xffff0000 && dst[15] == 0xff0000ff, "upright %08x %08x",
+        dst[0], dst[15]);
+  thumb_downscale(src, w, h, stride, true, false, dst, 4, 4);
+  CHECK(dst[0] == 0xff0000ff && dst[15] == 0xffff0000, "inverted %08x %08x",
+        dst[0], dst[15]);
+  free(src);
+}
+
+static void test_cache(void) {
+  uint32_t *src = make_frame(640, 400, 640 * 4, 0xff00ff00);
+  char addr[32];
+
+  CHECK(thumbs_lookup("0x1") == NULL, "empty cache has a preview");
+  CHECK(thumbs_store("0x1", src, 640, 400, 640 * 4, false, false) == 0,
+        "store failed");
+  const Thumbnail *t = thumbs_lookup("0x1");
+  CHECK(t && t->width == 256 && t->height == 160 &&
+            t->pixels[0] == 0xff00ff00,
+        "stored preview wrong");
+
+  uint64_t first = t ? t->generation : 0;
+
+  /* Restoring the same window reuses its slot */
+  src[0] = 0xffffffff;
+  thumbs_store("0x1", src, 640, 400, 640 * 4, false, false);
+  t = thumbs_lookup("0x1");
+  CHECK(t && t->pixels[0] != 0xff00ff00, "preview not refreshed");
+  CHECK(t && t->generation > first, "refreshed preview kept its generation");
+
+  /* Other windows' captures leave a preview's generation alone */
+  uint64_t refreshed = t ? t->generation : 0;
+  thumbs_store("0x2", src, 640, 400, 640 * 4, false, false);
+  t = thumbs_lookup("0x1");
+  CHECK(t && t->generation == refreshed, "generation moved with 0x2");
+
+  /* Filling the cache evicts the least recently used window */
+  for (int i = 2; i <= THUMB_CACHE_SIZE; i++) {
+    snprintf(addr, sizeof(addr), "0x%d", i);
+    thumbs_store(addr, src, 640, 400, 640 * 4, false, false);
+  }
+  thumbs_lookup("0x1"); /* 0x2 is now the oldest */
+  thumbs_store("0xnew", src, 640, 400, 640 * 4, false, false);
+  CHECK(thumbs_lookup("0x1") != NULL, "recently used preview evicted");
+  CHECK(thumbs_lookup("0x2") == NULL, "oldest preview kept");
+  CHECK(thumbs_lookup("0xnew") != NULL, "new preview missing");
+
+  thumbs_forget("0x1");
+  CHECK(thumbs_lookup("0x1") == NULL, "forgotten preview still cached");
+
+  CHECK(thumbs_store("0x0123456789abcdef0123456789abcdef", src, 640, 400,
+                     640 * 4, false, false) < 0,
+        "oversized address accepted");
+
+  thumbs_cleanup();
+  CHECK(thumbs_lookup("0xnew") == NULL, "cleanup left previews behind");
+  free(src);
+}
+
+int main(void) {
+  test_fit();
+  test_solid();
+  test_average();
+  test_y_invert();
+  test_cache();
+
+  if (failures) {
+    fprintf(stderr, "%d check(s) failed\n", failures);
+    return 1;
+  }
+  printf("thumbnail: all checks passed\n");
+  return 0;
+}